@@ -1,4 +1,4 @@
-QT       += core gui network
+QT       += core gui network svg sql concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -11,13 +11,77 @@ DEFINES += QT_DEPRECATED_WARNINGS
 CONFIG += c++11
 
 SOURCES += \
+        alertengine.cpp \
+        alertsdialog.cpp \
+        archiveingestor.cpp \
+        cityindex.cpp \
+        climatedialog.cpp \
+        ensemblechart.cpp \
+        ensembleforecast.cpp \
+        favoritesdelegate.cpp \
+        favoritesmodel.cpp \
+        favoritesstore.cpp \
+        forecastdayrow.cpp \
+        forecastdetail.cpp \
+        heatmapdialog.cpp \
+        historydialog.cpp \
         main.cpp \
         mainwindow.cpp \
-        translator.cpp
+        memorybench.cpp \
+        networkcapture.cpp \
+        nowcast.cpp \
+        nowcastchart.cpp \
+        observationhistory.cpp \
+        regiongrid.cpp \
+        requestscheduler.cpp \
+        serverbench.cpp \
+        singleinstance.cpp \
+        snapshotaggregator.cpp \
+        startupprofile.cpp \
+        stylebench.cpp \
+        suggestionprefetcher.cpp \
+        themeengine.cpp \
+        translator.cpp \
+        weathericons.cpp \
+        weatherrecords.cpp \
+        weatherserver.cpp \
+        weatherservice.cpp
 
 HEADERS += \
+        alertengine.h \
+        alertsdialog.h \
+        archiveingestor.h \
+        cityindex.h \
+        climatedialog.h \
+        ensemblechart.h \
+        ensembleforecast.h \
+        favoritesdelegate.h \
+        favoritesmodel.h \
+        favoritesstore.h \
+        forecastdayrow.h \
+        forecastdetail.h \
+        heatmapdialog.h \
+        historydialog.h \
         mainwindow.h \
-        translator.h
+        memorybench.h \
+        networkcapture.h \
+        nowcast.h \
+        nowcastchart.h \
+        observationhistory.h \
+        regiongrid.h \
+        requestscheduler.h \
+        serverbench.h \
+        singleinstance.h \
+        snapshotaggregator.h \
+        startupprofile.h \
+        stylebench.h \
+        suggestionprefetcher.h \
+        themeengine.h \
+        translator.h \
+        weathericons.h \
+        weatherrecords.h \
+        weatherserver.h \
+        weatherservice.h
 
 FORMS += \
         mainwindow.ui
@@ -27,3 +91,21 @@ RESOURCES += \
 
 RC_FILE += res/file.rc
 OTHER_FILES += res/file.rc
+
+# make startup-bench: медианы фаз холодного запуска по 10 прогонам
+startupbench.target = startup-bench
+startupbench.depends = $(TARGET)
+startupbench.commands = ./$(TARGET) --bench-startup 10
+QMAKE_EXTRA_TARGETS += startupbench
+
+# make style-bench: полировка и раскладка 16 строк прогноза, таблица стилей против палитры
+stylebench.target = style-bench
+stylebench.depends = $(TARGET)
+stylebench.commands = ./$(TARGET) --bench-style 16
+QMAKE_EXTRA_TARGETS += stylebench
+
+# make server-bench: 300 одновременных клиентов HTTP-сервера против локальной заглушки API
+serverbench.target = server-bench
+serverbench.depends = $(TARGET)
+serverbench.commands = ./$(TARGET) --bench-server 300
+QMAKE_EXTRA_TARGETS += serverbench
@@ -0,0 +1,199 @@
+#include "alertengine.h"
+#include <QRegularExpression>
+#include <QtMath>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+const char *FIELD_NAMES[AlertSample::FieldCount] = {
+    "temp", "feels", "humidity", "wind", "code", "code24h", "min24h", "max24h"
+};
+
+bool sameValue(float a, float b)
+{
+    return (qIsNaN(a) && qIsNaN(b)) || a == b;
+}
+}
+
+AlertSample::AlertSample()
+{
+    for (int i = 0; i < FieldCount; ++i) {
+        values[i] = float(qQNaN());
+    }
+}
+
+bool AlertRule::matches(float value) const
+{
+    if (qIsNaN(value)) return false;
+
+    switch (op) {
+    case Less: return value < threshold;
+    case LessEqual: return value <= threshold;
+    case Greater: return value > threshold;
+    case GreaterEqual: return value >= threshold;
+    case Equal: return value == threshold;
+    }
+    return false;
+}
+
+AlertEngine::AlertEngine(QObject *parent)
+    : QObject(parent)
+    , m_ruleCount(0)
+    , m_checks(0)
+{
+}
+
+QStringList AlertEngine::fieldNames()
+{
+    QStringList names;
+    for (int i = 0; i < AlertSample::FieldCount; ++i) {
+        names << FIELD_NAMES[i];
+    }
+    return names;
+}
+
+bool AlertEngine::compile(const QString &text, AlertRule *rule, QString *error)
+{
+    static const QRegularExpression pattern("^\\s*([a-z0-9]+)\\s*(<=|>=|==|=|<|>)\\s*([-+]?[0-9]+(?:[.,][0-9]+)?)\\s*$",
+                                            QRegularExpression::CaseInsensitiveOption);
+
+    QRegularExpressionMatch match = pattern.match(text);
+    if (!match.hasMatch()) {
+        if (error) *error = text;
+        return false;
+    }
+
+    int field = fieldNames().indexOf(match.captured(1).toLower());
+    if (field < 0) {
+        if (error) *error = text;
+        return false;
+    }
+
+    QString op = match.captured(2);
+    rule->field = static_cast<AlertSample::Field>(field);
+    if (op == "<") rule->op = AlertRule::Less;
+    else if (op == "<=") rule->op = AlertRule::LessEqual;
+    else if (op == ">") rule->op = AlertRule::Greater;
+    else if (op == ">=") rule->op = AlertRule::GreaterEqual;
+    else rule->op = AlertRule::Equal;
+
+    rule->threshold = match.captured(3).replace(',', '.').toFloat();
+    rule->text = text.simplified();
+    return true;
+}
+
+QStringList AlertEngine::setRules(const QStringList &rules)
+{
+    QStringList errors;
+
+    m_ruleTexts.clear();
+    for (int f = 0; f < AlertSample::FieldCount; ++f) {
+        m_byField[f].clear();
+    }
+
+    int id = 0;
+    for (const QString &text : rules) {
+        if (text.trimmed().isEmpty()) continue;
+
+        AlertRule rule;
+        QString error;
+        if (!compile(text, &rule, &error)) {
+            errors << error;
+            continue;
+        }
+        rule.id = id++;
+        m_ruleTexts << rule.text;
+        m_byField[rule.field].append(rule);
+    }
+    m_ruleCount = id;
+
+    for (int f = 0; f < AlertSample::FieldCount; ++f) {
+        std::sort(m_byField[f].begin(), m_byField[f].end(),
+                  [](const AlertRule &a, const AlertRule &b) { return a.threshold < b.threshold; });
+    }
+
+    qDebug() << "Alert rules compiled:" << m_ruleCount << "invalid:" << errors.size();
+
+    // Правила сменились: уже известные значения проверяются заново, с чистого состояния
+    const QHash<QString, AlertSample> samples = m_lastSamples;
+    m_lastSamples.clear();
+    m_activeRules.clear();
+    for (auto it = samples.constBegin(); it != samples.constEnd(); ++it) {
+        update(it.key(), it.value());
+    }
+
+    return errors;
+}
+
+QStringList AlertEngine::rules() const
+{
+    return m_ruleTexts;
+}
+
+void AlertEngine::update(const QString &location, const AlertSample &sample)
+{
+    AlertSample &last = m_lastSamples[location];
+    QVector<bool> &active = m_activeRules[location];
+    if (active.size() != m_ruleCount) {
+        active.fill(false, m_ruleCount);
+    }
+
+    qint64 checksBefore = m_checks;
+    int changedFields = 0;
+
+    for (int f = 0; f < AlertSample::FieldCount; ++f) {
+        float current = sample.values[f];
+        // Не пришло или не изменилось - правила этого поля не трогаем
+        if (qIsNaN(current) || sameValue(current, last.values[f])) continue;
+
+        ++changedFields;
+        float previous = last.values[f];
+        last.values[f] = current;
+        if (!m_byField[f].isEmpty()) {
+            evaluateField(location, f, previous, current, active);
+        }
+    }
+
+    if (changedFields > 0) {
+        qDebug() << "Alerts evaluated:" << location << "changed fields:" << changedFields
+                 << "checks:" << (m_checks - checksBefore) << "rules:" << m_ruleCount;
+    }
+}
+
+void AlertEngine::forget(const QString &location)
+{
+    m_lastSamples.remove(location);
+    m_activeRules.remove(location);
+}
+
+void AlertEngine::evaluateField(const QString &location, int field, float previous, float current,
+                                QVector<bool> &active)
+{
+    const QVector<AlertRule> &rules = m_byField[field];
+
+    // Первое значение поля - проверяются все его правила,
+    // иначе только пороги в отрезке [min(prev, cur), max(prev, cur)]
+    auto begin = rules.constBegin();
+    auto end = rules.constEnd();
+    if (!qIsNaN(previous)) {
+        float low = qMin(previous, current);
+        float high = qMax(previous, current);
+        begin = std::lower_bound(rules.constBegin(), rules.constEnd(), low,
+                                 [](const AlertRule &rule, float value) { return rule.threshold < value; });
+        end = std::upper_bound(begin, rules.constEnd(), high,
+                               [](float value, const AlertRule &rule) { return value < rule.threshold; });
+    }
+
+    for (auto it = begin; it != end; ++it) {
+        ++m_checks;
+        bool matches = it->matches(current);
+        if (matches == active[it->id]) continue;
+
+        active[it->id] = matches;
+        // Срабатывает только переход в истину; возврат в ложь перевзводит правило
+        if (matches) {
+            qDebug() << "Alert triggered:" << location << it->text << "value:" << current;
+            emit triggered(location, it->text, current);
+        }
+    }
+}
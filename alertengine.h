@@ -0,0 +1,78 @@
+#ifndef ALERTENGINE_H
+#define ALERTENGINE_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+
+// Значения, по которым проверяются правила. NaN - поле в этом обновлении не пришло.
+struct AlertSample {
+    enum Field {
+        Temperature,
+        FeelsLike,
+        Humidity,
+        WindSpeed,
+        WeatherCode,
+        MaxCode24h,
+        MinTemp24h,
+        MaxTemp24h,
+        FieldCount
+    };
+
+    AlertSample();
+    float values[FieldCount];
+};
+
+// Правило вида "<поле> <оператор> <число>", например "temp < -15" или "code24h >= 95"
+struct AlertRule {
+    enum Op { Less, LessEqual, Greater, GreaterEqual, Equal };
+
+    int id;
+    AlertSample::Field field;
+    Op op;
+    float threshold;
+    QString text;
+
+    bool matches(float value) const;
+};
+
+// Правила разложены по полям и отсортированы по порогу. Истинность правила меняется
+// только при переходе значения через его порог, поэтому при обновлении проверяются
+// лишь изменившиеся поля и лишь правила с порогом между старым и новым значением.
+class AlertEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AlertEngine(QObject *parent = nullptr);
+
+    static bool compile(const QString &text, AlertRule *rule, QString *error);
+    static QStringList fieldNames();
+
+    // Возвращает тексты правил, которые не удалось разобрать
+    QStringList setRules(const QStringList &rules);
+    QStringList rules() const;
+
+    void update(const QString &location, const AlertSample &sample);
+    void forget(const QString &location);
+
+signals:
+    void triggered(const QString &location, const QString &rule, float value);
+
+private:
+    void evaluateField(const QString &location, int field, float previous, float current,
+                       QVector<bool> &active);
+
+    QStringList m_ruleTexts;
+    QVector<AlertRule> m_byField[AlertSample::FieldCount];
+    int m_ruleCount;
+
+    // Последние значения и активные правила по каждому городу
+    QHash<QString, AlertSample> m_lastSamples;
+    QHash<QString, QVector<bool>> m_activeRules;
+
+    qint64 m_checks;
+};
+
+#endif // ALERTENGINE_H
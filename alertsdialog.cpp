@@ -0,0 +1,67 @@
+#include "alertsdialog.h"
+#include "alertengine.h"
+#include "translator.h"
+#include <QPlainTextEdit>
+#include <QLabel>
+#include <QDialogButtonBox>
+#include <QVBoxLayout>
+
+AlertsDialog::AlertsDialog(const QStringList &rules, QWidget *parent)
+    : QDialog(parent)
+    , m_editor(new QPlainTextEdit(this))
+    , m_errorLabel(new QLabel(this))
+{
+    setWindowTitle(TR("Alerts/title"));
+    resize(420, 320);
+
+    QLabel *help = new QLabel(TR("Alerts/help") + "\n" + AlertEngine::fieldNames().join("  "), this);
+    help->setWordWrap(true);
+
+    m_editor->setPlainText(rules.join('\n'));
+    m_errorLabel->setWordWrap(true);
+    m_errorLabel->hide();
+
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
+    connect(buttons, &QDialogButtonBox::accepted, this, &AlertsDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, this, &AlertsDialog::reject);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(help);
+    layout->addWidget(m_editor, 1);
+    layout->addWidget(m_errorLabel);
+    layout->addWidget(buttons);
+}
+
+QStringList AlertsDialog::rules() const
+{
+    QStringList result;
+    const QStringList lines = m_editor->toPlainText().split('\n');
+    for (const QString &line : lines) {
+        if (!line.trimmed().isEmpty()) {
+            result << line.simplified();
+        }
+    }
+    return result;
+}
+
+void AlertsDialog::accept()
+{
+    // Ошибочные строки показываем сразу, не закрывая диалог
+    QStringList invalid;
+    const QStringList lines = rules();
+    for (const QString &line : lines) {
+        AlertRule rule;
+        QString error;
+        if (!AlertEngine::compile(line, &rule, &error)) {
+            invalid << error;
+        }
+    }
+
+    if (!invalid.isEmpty()) {
+        m_errorLabel->setText(TR("Alerts/invalid") + "\n" + invalid.join('\n'));
+        m_errorLabel->show();
+        return;
+    }
+
+    QDialog::accept();
+}
@@ -0,0 +1,27 @@
+#ifndef ALERTSDIALOG_H
+#define ALERTSDIALOG_H
+
+#include <QDialog>
+
+class QPlainTextEdit;
+class QLabel;
+
+// Редактор правил оповещений: одно правило на строку
+class AlertsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    AlertsDialog(const QStringList &rules, QWidget *parent = nullptr);
+
+    QStringList rules() const;
+
+public slots:
+    void accept() override;
+
+private:
+    QPlainTextEdit *m_editor;
+    QLabel *m_errorLabel;
+};
+
+#endif // ALERTSDIALOG_H
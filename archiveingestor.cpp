@@ -0,0 +1,449 @@
+#include "archiveingestor.h"
+#include <QNetworkReply>
+#include <QUrlQuery>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QtMath>
+#include <QDebug>
+#include <algorithm>
+#include <vector>
+
+namespace {
+const char *ARCHIVE_API_URL = "http://archive-api.open-meteo.com/v1/archive";
+const int CHUNK_DAYS = 365;
+const int MAX_IN_FLIGHT = 4;
+const float DEGREE_DAY_BASE = 18.0f;
+
+// Разбор числа без strtof: не зависит от LC_NUMERIC и не копирует строку
+bool parseNumber(const char *&p, const char *end, float *value)
+{
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    double result = 0;
+    bool digits = false;
+    while (p < end && *p >= '0' && *p <= '9') {
+        result = result * 10 + (*p - '0');
+        ++p;
+        digits = true;
+    }
+    if (p < end && *p == '.') {
+        ++p;
+        double scale = 0.1;
+        while (p < end && *p >= '0' && *p <= '9') {
+            result += (*p - '0') * scale;
+            scale *= 0.1;
+            ++p;
+            digits = true;
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negativeExp = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negativeExp = (*p == '-');
+            ++p;
+        }
+        int exponent = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            exponent = exponent * 10 + (*p - '0');
+            ++p;
+        }
+        result *= qPow(10.0, negativeExp ? -exponent : exponent);
+    }
+
+    *value = float(negative ? -result : result);
+    return digits;
+}
+
+// Ядра агрегатов: плоские циклы по непрерывным массивам без ранних выходов,
+// пропуски (NaN) маскируются, а не обходятся ветвлением - такие циклы векторизуются
+inline void sumValid(const float *values, int count, float *sum, int *valid)
+{
+    float s = 0.0f;
+    int n = 0;
+    for (int i = 0; i < count; ++i) {
+        float v = values[i];
+        bool ok = (v == v);
+        s += ok ? v : 0.0f;
+        n += ok ? 1 : 0;
+    }
+    *sum = s;
+    *valid = n;
+}
+
+inline void degreeDays(const float *daily, int count, float base, float *heating, float *cooling)
+{
+    float h = 0.0f;
+    float c = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        float v = daily[i];
+        bool ok = (v == v);
+        h += ok ? qMax(0.0f, base - v) : 0.0f;
+        c += ok ? qMax(0.0f, v - base) : 0.0f;
+    }
+    *heating = h;
+    *cooling = c;
+}
+
+struct MonthSpan {
+    int year;
+    int month;
+    int firstDay;
+    int days;
+};
+
+struct MonthTask {
+    int month;
+    MonthlyClimate result;
+};
+
+struct YearTask {
+    int year;
+    YearlyDegreeDays result;
+};
+}
+
+ArchiveIngestor::ArchiveIngestor(RequestScheduler *scheduler, QObject *parent)
+    : QObject(parent)
+    , m_scheduler(scheduler)
+    , m_point()
+    , m_nextChunk(0)
+    , m_inFlight(0)
+    , m_completed(0)
+    , m_running(false)
+    , m_generation(0)
+    , m_startedAt(0)
+{
+}
+
+void ArchiveIngestor::start(const QString &location, const GeoPoint &point,
+                            const QDate &from, const QDate &to)
+{
+    cancel();
+
+    m_location = location;
+    m_point = point;
+    m_from = from;
+    m_to = to;
+    m_running = true;
+    m_startedAt = QDateTime::currentMSecsSinceEpoch();
+
+    int days = int(from.daysTo(to)) + 1;
+    m_hourly = QSharedPointer<QVector<float>>::create(days * 24, float(qQNaN()));
+
+    m_chunks.clear();
+    for (QDate day = from; day <= to; day = day.addDays(CHUNK_DAYS)) {
+        Chunk chunk;
+        chunk.from = day;
+        chunk.to = qMin(day.addDays(CHUNK_DAYS - 1), to);
+        chunk.offset = int(from.daysTo(day)) * 24;
+        chunk.hours = (int(day.daysTo(chunk.to)) + 1) * 24;
+        chunk.ticket = 0;
+        chunk.done = false;
+        chunk.failed = false;
+        m_chunks.append(chunk);
+    }
+
+    m_nextChunk = 0;
+    m_inFlight = 0;
+    m_completed = 0;
+
+    qDebug() << "Archive ingest:" << location << from << to << "chunks:" << m_chunks.size();
+
+    emit progress(0, m_chunks.size());
+    for (int i = 0; i < MAX_IN_FLIGHT; ++i) {
+        launchNext();
+    }
+}
+
+void ArchiveIngestor::cancel()
+{
+    if (!m_running) return;
+
+    // Новое поколение: ответы и разборы старого запуска будут проигнорированы
+    ++m_generation;
+    m_running = false;
+    for (Chunk &chunk : m_chunks) {
+        if (chunk.ticket) {
+            m_scheduler->cancel(chunk.ticket);
+            chunk.ticket = 0;
+        }
+    }
+}
+
+void ArchiveIngestor::launchNext()
+{
+    if (m_nextChunk >= m_chunks.size() || m_inFlight >= MAX_IN_FLIGHT) return;
+
+    int index = m_nextChunk++;
+    Chunk &chunk = m_chunks[index];
+
+    QUrl url(ARCHIVE_API_URL);
+    QUrlQuery query;
+    query.addQueryItem("latitude", QString::number(m_point.lat));
+    query.addQueryItem("longitude", QString::number(m_point.lon));
+    query.addQueryItem("start_date", chunk.from.toString(Qt::ISODate));
+    query.addQueryItem("end_date", chunk.to.toString(Qt::ISODate));
+    query.addQueryItem("hourly", "temperature_2m");
+    query.addQueryItem("timezone", "GMT");
+    url.setQuery(query);
+
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::UserAgentHeader, "SimpleWeather/1.0");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    request.setTransferTimeout(30000);
+#endif
+
+    // Архив - фоновая массовая загрузка: самый низкий класс планировщика
+    quint64 generation = m_generation;
+    chunk.ticket = m_scheduler->get(request, RequestScheduler::Prefetch, m_location, this,
+                                    [this, index, generation](QNetworkReply *reply) {
+        if (generation != m_generation) return;
+        onChunkFinished(index, reply);
+    });
+    ++m_inFlight;
+}
+
+void ArchiveIngestor::onChunkFinished(int index, QNetworkReply *reply)
+{
+    Chunk &chunk = m_chunks[index];
+    chunk.ticket = 0;
+    --m_inFlight;
+
+    // Окно освободилось - следующий кусок качается, пока этот разбирается
+    launchNext();
+
+    if (reply->error() != QNetworkReply::NoError) {
+        qWarning() << "Archive chunk failed:" << chunk.from << chunk.to << reply->errorString();
+        chunk.failed = true;
+        onChunkDecoded(index, 0);
+        return;
+    }
+
+    QByteArray body = reply->readAll();
+    QSharedPointer<QVector<float>> hourly = m_hourly;
+    float *target = hourly->data() + chunk.offset;
+    int capacity = chunk.hours;
+    quint64 generation = m_generation;
+
+    QFutureWatcher<int> *watcher = new QFutureWatcher<int>(this);
+    connect(watcher, &QFutureWatcher<int>::finished, this, [this, watcher, index, generation]() {
+        watcher->deleteLater();
+        if (generation != m_generation) return;
+        onChunkDecoded(index, watcher->result());
+    });
+    watcher->setFuture(QtConcurrent::run([body, hourly, target, capacity]() {
+        return decodeHourlyColumn(body, "temperature_2m", target, capacity);
+    }));
+}
+
+void ArchiveIngestor::onChunkDecoded(int index, int decoded)
+{
+    Chunk &chunk = m_chunks[index];
+    chunk.done = true;
+    if (decoded == 0) {
+        chunk.failed = true;
+    }
+
+    ++m_completed;
+    emit progress(m_completed, m_chunks.size());
+
+    if (m_completed == m_chunks.size()) {
+        finishIngest();
+    }
+}
+
+void ArchiveIngestor::finishIngest()
+{
+    qint64 ingestMs = QDateTime::currentMSecsSinceEpoch() - m_startedAt;
+
+    int failed = 0;
+    for (const Chunk &chunk : m_chunks) {
+        if (chunk.failed) ++failed;
+    }
+
+    QSharedPointer<QVector<float>> hourly = m_hourly;
+    QDate from = m_from;
+    quint64 generation = m_generation;
+
+    QFutureWatcher<ClimateSummary> *watcher = new QFutureWatcher<ClimateSummary>(this);
+    connect(watcher, &QFutureWatcher<ClimateSummary>::finished, this,
+            [this, watcher, generation, ingestMs, failed]() {
+        watcher->deleteLater();
+        if (generation != m_generation) return;
+
+        ClimateSummary summary = watcher->result();
+        summary.location = m_location;
+        summary.to = m_to;
+        summary.ingestMs = ingestMs;
+        summary.failedChunks = failed;
+        m_running = false;
+
+        qDebug() << "Archive ingest done:" << summary.location << "hours:" << summary.hours
+                 << "ingest ms:" << summary.ingestMs << "aggregate ms:" << summary.aggregateMs
+                 << "failed chunks:" << failed;
+
+        emit finished(summary);
+    });
+    watcher->setFuture(QtConcurrent::run([hourly, from]() {
+        return aggregate(*hourly, from, DEGREE_DAY_BASE);
+    }));
+}
+
+int ArchiveIngestor::decodeHourlyColumn(const QByteArray &json, const QByteArray &key,
+                                        float *out, int capacity)
+{
+    // В ответе ключ встречается дважды: в "hourly_units" и в "hourly"
+    int hourlyPos = json.indexOf("\"hourly\"");
+    if (hourlyPos < 0) return 0;
+
+    int keyPos = json.indexOf("\"" + key + "\"", hourlyPos);
+    if (keyPos < 0) return 0;
+    int arrayPos = json.indexOf('[', keyPos);
+    if (arrayPos < 0) return 0;
+
+    const char *p = json.constData() + arrayPos + 1;
+    const char *end = json.constData() + json.size();
+    int count = 0;
+
+    while (p < end && count < capacity) {
+        while (p < end && (*p == ' ' || *p == ',' || *p == '\n' || *p == '\r' || *p == '\t')) ++p;
+        if (p >= end || *p == ']') break;
+
+        if (*p == 'n') {
+            // null - пропуск в данных
+            out[count++] = float(qQNaN());
+            p += 4;
+            continue;
+        }
+
+        float value;
+        if (!parseNumber(p, end, &value)) break;
+        out[count++] = value;
+    }
+
+    return count;
+}
+
+ClimateSummary ArchiveIngestor::aggregate(const QVector<float> &hourly, const QDate &from, float baseTemp)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    ClimateSummary summary;
+    summary.from = from;
+    summary.hours = hourly.size();
+    summary.failedChunks = 0;
+    summary.ingestMs = 0;
+
+    int days = hourly.size() / 24;
+
+    // Разбиение на непрерывные отрезки "год-месяц" по индексам дней
+    QVector<MonthSpan> spans;
+    QDate date = from;
+    for (int day = 0; day < days; ) {
+        MonthSpan span;
+        span.year = date.year();
+        span.month = date.month();
+        span.firstDay = day;
+        span.days = qMin(date.daysInMonth() - date.day() + 1, days - day);
+        spans.append(span);
+
+        day += span.days;
+        date = date.addDays(span.days);
+    }
+
+    // Среднесуточные температуры: отрезки считаются параллельно
+    QVector<float> daily(days, float(qQNaN()));
+    const float *source = hourly.constData();
+    float *dailyOut = daily.data();
+    QtConcurrent::blockingMap(spans, [source, dailyOut](MonthSpan &span) {
+        for (int d = span.firstDay; d < span.firstDay + span.days; ++d) {
+            float sum;
+            int valid;
+            sumValid(source + d * 24, 24, &sum, &valid);
+            dailyOut[d] = valid > 0 ? sum / valid : float(qQNaN());
+        }
+    });
+
+    // Климатология по календарным месяцам: 12 независимых задач
+    QVector<MonthTask> monthTasks(12);
+    for (int m = 0; m < 12; ++m) {
+        monthTasks[m].month = m + 1;
+    }
+    QtConcurrent::blockingMap(monthTasks, [&spans, source](MonthTask &task) {
+        std::vector<float> values;
+        double sum = 0;
+        for (const MonthSpan &span : spans) {
+            if (span.month != task.month) continue;
+            const float *begin = source + span.firstDay * 24;
+            int count = span.days * 24;
+
+            float spanSum;
+            int valid;
+            sumValid(begin, count, &spanSum, &valid);
+            sum += spanSum;
+
+            values.reserve(values.size() + valid);
+            for (int i = 0; i < count; ++i) {
+                if (begin[i] == begin[i]) values.push_back(begin[i]);
+            }
+        }
+
+        MonthlyClimate &result = task.result;
+        result.month = task.month;
+        result.samples = int(values.size());
+        if (values.empty()) {
+            result.mean = result.p10 = result.p50 = result.p90 = float(qQNaN());
+            return;
+        }
+
+        result.mean = float(sum / values.size());
+        auto percentile = [&values](double q) {
+            size_t index = size_t(q * (values.size() - 1));
+            std::nth_element(values.begin(), values.begin() + index, values.end());
+            return values[index];
+        };
+        result.p10 = percentile(0.10);
+        result.p50 = percentile(0.50);
+        result.p90 = percentile(0.90);
+    });
+
+    // Градусо-сутки отопления и охлаждения по годам
+    QVector<YearTask> yearTasks;
+    for (int year = from.year(); year <= from.addDays(qMax(days - 1, 0)).year(); ++year) {
+        YearTask task;
+        task.year = year;
+        yearTasks.append(task);
+    }
+    const float *dailyIn = daily.constData();
+    QtConcurrent::blockingMap(yearTasks, [&spans, dailyIn, baseTemp](YearTask &task) {
+        task.result.year = task.year;
+        task.result.heating = 0;
+        task.result.cooling = 0;
+        for (const MonthSpan &span : spans) {
+            if (span.year != task.year) continue;
+            float heating;
+            float cooling;
+            degreeDays(dailyIn + span.firstDay, span.days, baseTemp, &heating, &cooling);
+            task.result.heating += heating;
+            task.result.cooling += cooling;
+        }
+    });
+
+    for (const MonthTask &task : monthTasks) {
+        summary.months.append(task.result);
+    }
+    for (const YearTask &task : yearTasks) {
+        summary.years.append(task.result);
+    }
+
+    summary.aggregateMs = timer.elapsed();
+    return summary;
+}
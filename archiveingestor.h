@@ -0,0 +1,97 @@
+#ifndef ARCHIVEINGESTOR_H
+#define ARCHIVEINGESTOR_H
+
+#include <QObject>
+#include <QDate>
+#include <QVector>
+#include <QList>
+#include <QSharedPointer>
+#include "cityindex.h"
+#include "requestscheduler.h"
+
+class QNetworkReply;
+
+struct MonthlyClimate {
+    int month;
+    float mean;
+    float p10;
+    float p50;
+    float p90;
+    int samples;
+};
+
+struct YearlyDegreeDays {
+    int year;
+    float heating;
+    float cooling;
+};
+
+struct ClimateSummary {
+    QString location;
+    QDate from;
+    QDate to;
+    int hours;
+    int failedChunks;
+    qint64 ingestMs;
+    qint64 aggregateMs;
+    QVector<MonthlyClimate> months;
+    QVector<YearlyDegreeDays> years;
+};
+
+// Загрузка почасового архива Open-Meteo кусками с ограниченным числом
+// одновременных запросов. Ответы разбираются сразу в непрерывный столбец float,
+// агрегаты считаются параллельно по месяцам и годам.
+class ArchiveIngestor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ArchiveIngestor(RequestScheduler *scheduler, QObject *parent = nullptr);
+
+    void start(const QString &location, const GeoPoint &point, const QDate &from, const QDate &to);
+    void cancel();
+    bool isRunning() const { return m_running; }
+
+    // Разбор массива чисел по ключу из блока "hourly" без построения JSON-дерева
+    static int decodeHourlyColumn(const QByteArray &json, const QByteArray &key,
+                                  float *out, int capacity);
+    static ClimateSummary aggregate(const QVector<float> &hourly, const QDate &from, float baseTemp);
+
+signals:
+    void progress(int done, int total);
+    void finished(const ClimateSummary &summary);
+
+private:
+    struct Chunk {
+        QDate from;
+        QDate to;
+        int offset; // индекс первого часа в общем столбце
+        int hours;
+        RequestScheduler::Ticket ticket;
+        bool done;
+        bool failed;
+    };
+
+    void launchNext();
+    void onChunkFinished(int index, QNetworkReply *reply);
+    void onChunkDecoded(int index, int decoded);
+    void finishIngest();
+
+    RequestScheduler *m_scheduler;
+    QString m_location;
+    GeoPoint m_point;
+    QDate m_from;
+    QDate m_to;
+
+    QVector<Chunk> m_chunks;
+    // Общий столбец живёт, пока его заполняют фоновые разборщики
+    QSharedPointer<QVector<float>> m_hourly;
+    int m_nextChunk;
+    int m_inFlight;
+    int m_completed;
+    bool m_running;
+    quint64 m_generation;
+    qint64 m_startedAt;
+};
+
+#endif // ARCHIVEINGESTOR_H
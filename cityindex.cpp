@@ -0,0 +1,202 @@
+#include "cityindex.h"
+#include <QFile>
+#include <QTextStream>
+#include <QRegularExpression>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const double EARTH_RADIUS_KM = 6371.0;
+const double PI = 3.14159265358979323846;
+const double DEG_TO_RAD = PI / 180.0;
+
+double squaredDistance(const double a[3], const double b[3])
+{
+    double dx = a[0] - b[0];
+    double dy = a[1] - b[1];
+    double dz = a[2] - b[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+}
+
+CityIndex::CityIndex()
+{
+}
+
+bool CityIndex::load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << "City dataset not found:" << path;
+        return false;
+    }
+
+    m_cities.clear();
+    m_nodes.clear();
+
+    // Формат строки: name,country,latitude,longitude
+    QTextStream in(&file);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    in.setCodec("UTF-8");
+#endif
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        QStringList parts = line.split(',');
+        if (parts.size() != 4) continue;
+
+        bool latOk = false;
+        bool lonOk = false;
+        CityRecord city;
+        city.name = parts[0].trimmed();
+        city.country = parts[1].trimmed();
+        city.position.lat = parts[2].toDouble(&latOk);
+        city.position.lon = parts[3].toDouble(&lonOk);
+        if (latOk && lonOk) {
+            m_cities.append(city);
+        }
+    }
+
+    m_nodes.resize(m_cities.size());
+    for (int i = 0; i < m_cities.size(); ++i) {
+        toUnitVector(m_cities[i].position, m_nodes[i].xyz);
+        m_nodes[i].city = i;
+    }
+    build(0, m_nodes.size(), 0);
+
+    qDebug() << "City index built, cities:" << m_cities.size();
+    return !m_cities.isEmpty();
+}
+
+void CityIndex::build(int begin, int end, int depth)
+{
+    if (end - begin <= 1) return;
+
+    int axis = depth % 3;
+    int mid = (begin + end) / 2;
+    std::nth_element(m_nodes.begin() + begin, m_nodes.begin() + mid, m_nodes.begin() + end,
+                     [axis](const Node &a, const Node &b) { return a.xyz[axis] < b.xyz[axis]; });
+
+    build(begin, mid, depth + 1);
+    build(mid + 1, end, depth + 1);
+}
+
+const CityRecord *CityIndex::nearest(const GeoPoint &point, double *distanceKm) const
+{
+    if (m_nodes.isEmpty()) return nullptr;
+
+    double p[3];
+    toUnitVector(point, p);
+
+    int best = -1;
+    double bestDist = 5.0; // больше максимального квадрата хорды (4)
+    searchNearest(0, m_nodes.size(), 0, p, &best, &bestDist);
+
+    const CityRecord *city = &m_cities[m_nodes[best].city];
+    if (distanceKm) {
+        *distanceKm = CityIndex::distanceKm(point, city->position);
+    }
+    return city;
+}
+
+void CityIndex::searchNearest(int begin, int end, int depth, const double p[3],
+                              int *best, double *bestDist) const
+{
+    if (begin >= end) return;
+
+    int mid = (begin + end) / 2;
+    const Node &node = m_nodes[mid];
+
+    double dist = squaredDistance(p, node.xyz);
+    if (dist < *bestDist) {
+        *bestDist = dist;
+        *best = mid;
+    }
+
+    int axis = depth % 3;
+    double delta = p[axis] - node.xyz[axis];
+
+    // Сначала ближняя половина, дальняя - только если её может пересечь сфера поиска
+    if (delta < 0) {
+        searchNearest(begin, mid, depth + 1, p, best, bestDist);
+        if (delta * delta < *bestDist) searchNearest(mid + 1, end, depth + 1, p, best, bestDist);
+    } else {
+        searchNearest(mid + 1, end, depth + 1, p, best, bestDist);
+        if (delta * delta < *bestDist) searchNearest(begin, mid, depth + 1, p, best, bestDist);
+    }
+}
+
+QList<const CityRecord*> CityIndex::withinRadius(const GeoPoint &point, double radiusKm) const
+{
+    QList<const CityRecord*> result;
+    if (m_nodes.isEmpty() || radiusKm <= 0) return result;
+
+    double p[3];
+    toUnitVector(point, p);
+
+    // Дуга большого круга -> длина хорды на единичной сфере
+    double angle = std::min(radiusKm / EARTH_RADIUS_KM, PI);
+    double chord = 2.0 * std::sin(angle / 2.0);
+
+    searchRadius(0, m_nodes.size(), 0, p, chord * chord, &result);
+    return result;
+}
+
+void CityIndex::searchRadius(int begin, int end, int depth, const double p[3],
+                             double limit, QList<const CityRecord*> *result) const
+{
+    if (begin >= end) return;
+
+    int mid = (begin + end) / 2;
+    const Node &node = m_nodes[mid];
+
+    if (squaredDistance(p, node.xyz) <= limit) {
+        result->append(&m_cities[node.city]);
+    }
+
+    int axis = depth % 3;
+    double delta = p[axis] - node.xyz[axis];
+    if (delta < 0 || delta * delta <= limit) searchRadius(begin, mid, depth + 1, p, limit, result);
+    if (delta >= 0 || delta * delta <= limit) searchRadius(mid + 1, end, depth + 1, p, limit, result);
+}
+
+double CityIndex::distanceKm(const GeoPoint &a, const GeoPoint &b)
+{
+    double dLat = (b.lat - a.lat) * DEG_TO_RAD;
+    double dLon = (b.lon - a.lon) * DEG_TO_RAD;
+    double h = std::sin(dLat / 2) * std::sin(dLat / 2) +
+               std::cos(a.lat * DEG_TO_RAD) * std::cos(b.lat * DEG_TO_RAD) *
+               std::sin(dLon / 2) * std::sin(dLon / 2);
+    return 2.0 * EARTH_RADIUS_KM * std::asin(std::min(1.0, std::sqrt(h)));
+}
+
+bool CityIndex::parseCoordinates(const QString &text, GeoPoint *point)
+{
+    // Принимаем "55.75, 37.62", "55.75 37.62" и "55.75;37.62"
+    static const QRegularExpression re(
+        "^\\s*([-+]?\\d{1,2}(?:\\.\\d+)?)\\s*[,;\\s]\\s*([-+]?\\d{1,3}(?:\\.\\d+)?)\\s*$");
+
+    QRegularExpressionMatch match = re.match(text);
+    if (!match.hasMatch()) return false;
+
+    double lat = match.captured(1).toDouble();
+    double lon = match.captured(2).toDouble();
+    if (lat < -90.0 || lat > 90.0 || lon < -180.0 || lon > 180.0) return false;
+
+    if (point) {
+        point->lat = lat;
+        point->lon = lon;
+    }
+    return true;
+}
+
+void CityIndex::toUnitVector(const GeoPoint &point, double out[3])
+{
+    double lat = point.lat * DEG_TO_RAD;
+    double lon = point.lon * DEG_TO_RAD;
+    out[0] = std::cos(lat) * std::cos(lon);
+    out[1] = std::cos(lat) * std::sin(lon);
+    out[2] = std::sin(lat);
+}
@@ -0,0 +1,54 @@
+#ifndef CITYINDEX_H
+#define CITYINDEX_H
+
+#include <QString>
+#include <QVector>
+#include <QList>
+
+struct GeoPoint {
+    double lat;
+    double lon;
+};
+
+struct CityRecord {
+    QString name;
+    QString country;
+    GeoPoint position;
+};
+
+// Пространственный индекс городов: k-d дерево по точкам на единичной сфере.
+// Ближайший сосед и поиск в радиусе - за O(log n) в среднем.
+class CityIndex
+{
+public:
+    CityIndex();
+
+    bool load(const QString &path);
+    bool isEmpty() const { return m_cities.isEmpty(); }
+    int size() const { return m_cities.size(); }
+
+    const CityRecord *nearest(const GeoPoint &point, double *distanceKm = nullptr) const;
+    QList<const CityRecord*> withinRadius(const GeoPoint &point, double radiusKm) const;
+
+    static double distanceKm(const GeoPoint &a, const GeoPoint &b);
+    static bool parseCoordinates(const QString &text, GeoPoint *point);
+
+private:
+    struct Node {
+        double xyz[3];
+        int city;
+    };
+
+    void build(int begin, int end, int depth);
+    void searchNearest(int begin, int end, int depth, const double p[3],
+                       int *best, double *bestDist) const;
+    void searchRadius(int begin, int end, int depth, const double p[3],
+                      double limit, QList<const CityRecord*> *result) const;
+    static void toUnitVector(const GeoPoint &point, double out[3]);
+
+    QVector<CityRecord> m_cities;
+    // Неявное сбалансированное дерево: медиана отрезка [begin, end) - его корень
+    QVector<Node> m_nodes;
+};
+
+#endif // CITYINDEX_H
@@ -0,0 +1,113 @@
+#include "climatedialog.h"
+#include "translator.h"
+#include <QProgressBar>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QLabel>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLocale>
+#include <QtMath>
+#include <QDebug>
+
+namespace {
+const int ARCHIVE_YEARS = 10;
+// Архив отстаёт от текущей даты на несколько дней
+const int ARCHIVE_LAG_DAYS = 7;
+}
+
+ClimateDialog::ClimateDialog(RequestScheduler *scheduler, const QString &location,
+                             const GeoPoint &point, bool celsius, QWidget *parent)
+    : QDialog(parent)
+    , m_ingestor(new ArchiveIngestor(scheduler, this))
+    , m_isCelsius(celsius)
+    , m_progress(new QProgressBar(this))
+    , m_monthsTable(new QTableWidget(12, 4, this))
+    , m_yearsTable(new QTableWidget(0, 3, this))
+    , m_statusLabel(new QLabel(this))
+{
+    setWindowTitle(TR("Climate/title") + ": " + location);
+    resize(720, 480);
+
+    m_monthsTable->setHorizontalHeaderLabels(QStringList()
+            << TR("Climate/mean") << TR("Climate/p10") << TR("Climate/p50") << TR("Climate/p90"));
+    m_monthsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_monthsTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+
+    QLocale locale(Translator::instance().currentLanguage() == "ru" ? QLocale::Russian : QLocale::English);
+    QStringList months;
+    for (int m = 1; m <= 12; ++m) {
+        months << locale.standaloneMonthName(m);
+    }
+    m_monthsTable->setVerticalHeaderLabels(months);
+
+    m_yearsTable->setHorizontalHeaderLabels(QStringList()
+            << TR("Climate/year") << TR("Climate/heating") << TR("Climate/cooling"));
+    m_yearsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_yearsTable->verticalHeader()->setVisible(false);
+    m_yearsTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+
+    QHBoxLayout *tables = new QHBoxLayout();
+    tables->addWidget(m_monthsTable, 3);
+    tables->addWidget(m_yearsTable, 2);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(m_progress);
+    layout->addLayout(tables, 1);
+    layout->addWidget(m_statusLabel);
+
+    connect(m_ingestor, &ArchiveIngestor::progress, this, &ClimateDialog::onProgress);
+    connect(m_ingestor, &ArchiveIngestor::finished, this, &ClimateDialog::onFinished);
+
+    QDate to = QDate::currentDate().addDays(-ARCHIVE_LAG_DAYS);
+    QDate from = to.addYears(-ARCHIVE_YEARS).addDays(1);
+    m_statusLabel->setText(TR("Climate/loading"));
+    m_ingestor->start(location, point, from, to);
+}
+
+void ClimateDialog::onProgress(int done, int total)
+{
+    m_progress->setRange(0, total);
+    m_progress->setValue(done);
+}
+
+void ClimateDialog::onFinished(const ClimateSummary &summary)
+{
+    m_progress->hide();
+
+    for (const MonthlyClimate &month : summary.months) {
+        int row = month.month - 1;
+        m_monthsTable->setItem(row, 0, new QTableWidgetItem(formatTemp(month.mean)));
+        m_monthsTable->setItem(row, 1, new QTableWidgetItem(formatTemp(month.p10)));
+        m_monthsTable->setItem(row, 2, new QTableWidgetItem(formatTemp(month.p50)));
+        m_monthsTable->setItem(row, 3, new QTableWidgetItem(formatTemp(month.p90)));
+    }
+
+    // Градусо-сутки в °F пересчитываются только масштабом: база тоже переводится
+    float scale = m_isCelsius ? 1.0f : 9.0f / 5.0f;
+    m_yearsTable->setRowCount(summary.years.size());
+    for (int i = 0; i < summary.years.size(); ++i) {
+        const YearlyDegreeDays &year = summary.years[i];
+        m_yearsTable->setItem(i, 0, new QTableWidgetItem(QString::number(year.year)));
+        m_yearsTable->setItem(i, 1, new QTableWidgetItem(QString::number(qRound(year.heating * scale))));
+        m_yearsTable->setItem(i, 2, new QTableWidgetItem(QString::number(qRound(year.cooling * scale))));
+    }
+
+    QString status = TR("Climate/summary")
+            .arg(summary.from.toString(Qt::ISODate))
+            .arg(summary.to.toString(Qt::ISODate))
+            .arg(summary.hours)
+            .arg(summary.ingestMs)
+            .arg(summary.aggregateMs);
+    if (summary.failedChunks > 0) {
+        status += " " + TR("Climate/partial").arg(summary.failedChunks);
+    }
+    m_statusLabel->setText(status);
+}
+
+QString ClimateDialog::formatTemp(float celsius) const
+{
+    if (qIsNaN(celsius)) return "—";
+    float value = m_isCelsius ? celsius : celsius * 9.0f / 5.0f + 32.0f;
+    return QString::number(value, 'f', 1) + (m_isCelsius ? "°C" : "°F");
+}
@@ -0,0 +1,36 @@
+#ifndef CLIMATEDIALOG_H
+#define CLIMATEDIALOG_H
+
+#include <QDialog>
+#include "archiveingestor.h"
+
+class QProgressBar;
+class QTableWidget;
+class QLabel;
+
+// Климатология по архиву: месячные нормы и градусо-сутки за последние годы
+class ClimateDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    ClimateDialog(RequestScheduler *scheduler, const QString &location,
+                  const GeoPoint &point, bool celsius, QWidget *parent = nullptr);
+
+private slots:
+    void onProgress(int done, int total);
+    void onFinished(const ClimateSummary &summary);
+
+private:
+    QString formatTemp(float celsius) const;
+
+    ArchiveIngestor *m_ingestor;
+    bool m_isCelsius;
+
+    QProgressBar *m_progress;
+    QTableWidget *m_monthsTable;
+    QTableWidget *m_yearsTable;
+    QLabel *m_statusLabel;
+};
+
+#endif // CLIMATEDIALOG_H
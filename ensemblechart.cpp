@@ -0,0 +1,134 @@
+#include "ensemblechart.h"
+#include "translator.h"
+#include <QPainter>
+#include <QPainterPath>
+#include <QDateTime>
+#include <QtMath>
+
+namespace {
+const int LEFT_MARGIN = 40;
+const int BOTTOM_MARGIN = 20;
+const int TOP_MARGIN = 22;
+}
+
+EnsembleChart::EnsembleChart(QWidget *parent)
+    : QWidget(parent)
+    , m_isCelsius(true)
+{
+    setMinimumHeight(240);
+}
+
+void EnsembleChart::setSeries(const EnsembleSeries &series, bool celsius)
+{
+    m_series = series;
+    m_isCelsius = celsius;
+    update();
+}
+
+float EnsembleChart::convert(float celsius) const
+{
+    return m_isCelsius ? celsius : celsius * 9.0f / 5.0f + 32.0f;
+}
+
+void EnsembleChart::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    const int steps = m_series.steps;
+    float low = 0;
+    float high = 0;
+    bool hasData = false;
+    for (int t = 0; t < steps; ++t) {
+        if (qIsNaN(m_series.min[t])) continue;
+        float a = convert(m_series.min[t]);
+        float b = convert(m_series.max[t]);
+        low = hasData ? qMin(low, a) : a;
+        high = hasData ? qMax(high, b) : b;
+        hasData = true;
+    }
+
+    painter.setPen(palette().color(QPalette::Text));
+    if (!hasData || steps < 2) {
+        painter.drawText(rect(), Qt::AlignCenter, TR("Forecast/ensemble_loading"));
+        return;
+    }
+
+    painter.drawText(QRect(0, 0, width(), TOP_MARGIN), Qt::AlignLeft | Qt::AlignVCenter,
+                     TR("Forecast/ensemble_models") + m_series.models.join("  "));
+
+    QRectF plot = QRectF(rect()).adjusted(LEFT_MARGIN, TOP_MARGIN, -8, -BOTTOM_MARGIN);
+    float range = qMax(high - low, 1.0f);
+    auto xAt = [&](int t) { return plot.left() + plot.width() * t / (steps - 1); };
+    auto yAt = [&](float celsius) {
+        return plot.bottom() - plot.height() * (convert(celsius) - low) / range;
+    };
+
+    QString unit = m_isCelsius ? "°C" : "°F";
+    painter.drawText(QRectF(0, plot.top() - 8, LEFT_MARGIN - 4, 16), Qt::AlignRight | Qt::AlignVCenter,
+                     QString::number(high, 'f', 0) + unit);
+    painter.drawText(QRectF(0, plot.bottom() - 8, LEFT_MARGIN - 4, 16), Qt::AlignRight | Qt::AlignVCenter,
+                     QString::number(low, 'f', 0) + unit);
+
+    // Полоса строится отрезками без пропусков: NaN разрывает полосу
+    QColor band = palette().color(QPalette::Highlight);
+    auto fillBand = [&](const QVector<float> &upper, const QVector<float> &lower, int alpha) {
+        QColor color = band;
+        color.setAlpha(alpha);
+        int t = 0;
+        while (t < steps) {
+            while (t < steps && qIsNaN(upper[t])) ++t;
+            int first = t;
+            while (t < steps && !qIsNaN(upper[t])) ++t;
+            if (t - first < 2) continue;
+
+            QPainterPath path;
+            path.moveTo(xAt(first), yAt(upper[first]));
+            for (int i = first + 1; i < t; ++i) path.lineTo(xAt(i), yAt(upper[i]));
+            for (int i = t - 1; i >= first; --i) path.lineTo(xAt(i), yAt(lower[i]));
+            path.closeSubpath();
+            painter.fillPath(path, color);
+        }
+    };
+
+    QVector<float> sigmaHigh(steps);
+    QVector<float> sigmaLow(steps);
+    for (int t = 0; t < steps; ++t) {
+        sigmaHigh[t] = m_series.mean[t] + m_series.spread[t];
+        sigmaLow[t] = m_series.mean[t] - m_series.spread[t];
+    }
+
+    fillBand(m_series.max, m_series.min, 60);
+    fillBand(sigmaHigh, sigmaLow, 110);
+
+    // Линия среднего
+    painter.setPen(QPen(band.darker(130), 2));
+    QPainterPath meanPath;
+    bool started = false;
+    for (int t = 0; t < steps; ++t) {
+        if (qIsNaN(m_series.mean[t])) {
+            started = false;
+            continue;
+        }
+        if (started) meanPath.lineTo(xAt(t), yAt(m_series.mean[t]));
+        else meanPath.moveTo(xAt(t), yAt(m_series.mean[t]));
+        started = true;
+    }
+    painter.drawPath(meanPath);
+
+    // Границы суток и подписи дней
+    painter.setPen(palette().color(QPalette::Mid));
+    qint64 day = 86400;
+    qint64 firstMidnight = (m_series.start + day - 1) / day * day;
+    for (qint64 ts = firstMidnight; ts < m_series.start + qint64(steps) * m_series.stepSeconds; ts += day) {
+        double x = plot.left() + plot.width() * double(ts - m_series.start)
+                / (double(steps - 1) * m_series.stepSeconds);
+        painter.setPen(palette().color(QPalette::Mid));
+        painter.drawLine(QPointF(x, plot.top()), QPointF(x, plot.bottom()));
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawText(QRectF(x + 2, plot.bottom() + 2, 80, BOTTOM_MARGIN - 2), Qt::AlignLeft,
+                         QDateTime::fromSecsSinceEpoch(ts, Qt::UTC).toString("ddd d"));
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef ENSEMBLECHART_H
+#define ENSEMBLECHART_H
+
+#include <QWidget>
+#include "ensembleforecast.h"
+
+// Полосы разброса моделей: min..max, среднее ± σ и линия среднего
+class EnsembleChart : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit EnsembleChart(QWidget *parent = nullptr);
+
+    void setSeries(const EnsembleSeries &series, bool celsius);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    float convert(float celsius) const;
+
+    EnsembleSeries m_series;
+    bool m_isCelsius;
+};
+
+#endif // ENSEMBLECHART_H
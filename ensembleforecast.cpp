@@ -0,0 +1,102 @@
+#include "ensembleforecast.h"
+#include <QJsonArray>
+#include <QtMath>
+#include <QDebug>
+#include <limits>
+
+EnsembleSeries::EnsembleSeries()
+    : locationId(0xffffffffu)
+    , start(0)
+    , stepSeconds(3600)
+    , steps(0)
+{
+}
+
+QStringList EnsembleForecast::defaultModels()
+{
+    return QStringList() << "icon_seamless" << "gfs_seamless" << "ecmwf_ifs025";
+}
+
+bool EnsembleForecast::parse(const QJsonObject &obj, const QStringList &models,
+                             const QString &variable, EnsembleSeries *series)
+{
+    const QJsonObject hourly = obj["hourly"].toObject();
+    const QJsonArray times = hourly["time"].toArray();
+    if (times.size() < 2) return false;
+
+    qint64 utcOffset = qint64(obj["utc_offset_seconds"].toDouble());
+    series->start = qint64(times[0].toDouble()) + utcOffset;
+    series->stepSeconds = int(times[1].toDouble() - times[0].toDouble());
+    series->steps = times.size();
+    series->models.clear();
+    series->values.clear();
+
+    // Каждая модель приходит отдельным столбцом "<variable>_<model>"
+    for (const QString &model : models) {
+        const QJsonArray column = hourly[variable + "_" + model].toArray();
+        if (column.isEmpty()) {
+            qDebug() << "Ensemble: no data for model" << model;
+            continue;
+        }
+
+        series->models << model;
+        int offset = series->values.size();
+        series->values.resize(offset + series->steps);
+        float *row = series->values.data() + offset;
+        for (int t = 0; t < series->steps; ++t) {
+            // null за горизонтом модели - NaN
+            row[t] = t < column.size() && column[t].isDouble() ? float(column[t].toDouble())
+                                                                : float(qQNaN());
+        }
+    }
+
+    return !series->models.isEmpty();
+}
+
+void EnsembleForecast::computeStats(EnsembleSeries *series)
+{
+    const int steps = series->steps;
+    const int modelCount = series->models.size();
+
+    QVector<float> sum(steps, 0.0f);
+    QVector<float> sumSq(steps, 0.0f);
+    QVector<float> count(steps, 0.0f);
+    series->min.fill(std::numeric_limits<float>::infinity(), steps);
+    series->max.fill(-std::numeric_limits<float>::infinity(), steps);
+
+    float *s = sum.data();
+    float *sq = sumSq.data();
+    float *n = count.data();
+    float *lo = series->min.data();
+    float *hi = series->max.data();
+
+    // Один проход по каждой строке модели: непрерывные массивы, без ветвлений,
+    // пропуски маскируются - внутренний цикл векторизуется компилятором
+    for (int m = 0; m < modelCount; ++m) {
+        const float *row = series->values.constData() + m * steps;
+        for (int t = 0; t < steps; ++t) {
+            float v = row[t];
+            bool ok = (v == v);
+            float x = ok ? v : 0.0f;
+            s[t] += x;
+            sq[t] += x * x;
+            n[t] += ok ? 1.0f : 0.0f;
+            lo[t] = ok && v < lo[t] ? v : lo[t];
+            hi[t] = ok && v > hi[t] ? v : hi[t];
+        }
+    }
+
+    series->mean.resize(steps);
+    series->spread.resize(steps);
+    float *mean = series->mean.data();
+    float *spread = series->spread.data();
+    const float nan = float(qQNaN());
+    for (int t = 0; t < steps; ++t) {
+        bool ok = n[t] > 0.0f;
+        float mu = ok ? s[t] / n[t] : nan;
+        mean[t] = mu;
+        spread[t] = ok ? std::sqrt(qMax(0.0f, sq[t] / n[t] - mu * mu)) : nan;
+        lo[t] = ok ? lo[t] : nan;
+        hi[t] = ok ? hi[t] : nan;
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef ENSEMBLEFORECAST_H
+#define ENSEMBLEFORECAST_H
+
+#include <QStringList>
+#include <QVector>
+#include <QJsonObject>
+
+// Почасовой прогноз нескольких моделей из одного запроса с models=.
+// Значения моделей лежат подряд: values[model * steps + step].
+struct EnsembleSeries {
+    QStringList models;
+    quint32 locationId;
+    qint64 start;       // местное время первого шага, записанное как UTC
+    int stepSeconds;
+    int steps;
+    QVector<float> values;
+
+    // Статистика по моделям на каждый шаг
+    QVector<float> mean;
+    QVector<float> min;
+    QVector<float> max;
+    QVector<float> spread;  // стандартное отклонение между моделями
+
+    EnsembleSeries();
+};
+
+class EnsembleForecast
+{
+public:
+    static QStringList defaultModels();
+
+    static bool parse(const QJsonObject &obj, const QStringList &models,
+                      const QString &variable, EnsembleSeries *series);
+    static void computeStats(EnsembleSeries *series);
+};
+
+#endif // ENSEMBLEFORECAST_H
@@ -0,0 +1,118 @@
+#include "favoritesdelegate.h"
+#include "favoritesmodel.h"
+#include "weathericons.h"
+#include <QPainter>
+#include <QPainterPath>
+#include <algorithm>
+
+namespace {
+const int ROW_HEIGHT = 48;
+const int ICON_SIZE = 28;
+const int SPARKLINE_WIDTH = 48;
+const int PADDING = 8;
+}
+
+FavoritesDelegate::FavoritesDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+    , m_isCelsius(true)
+{
+}
+
+QSize FavoritesDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    Q_UNUSED(index)
+    // Одинаковая высота строк: представление не измеряет каждую строку
+    return QSize(option.rect.width(), ROW_HEIGHT);
+}
+
+void FavoritesDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
+                              const QModelIndex &index) const
+{
+    const QPalette &pal = option.palette;
+    QRect rect = option.rect;
+
+    painter->save();
+
+    if (option.state & QStyle::State_Selected) {
+        painter->fillRect(rect, pal.color(QPalette::Highlight));
+    } else if (option.state & QStyle::State_MouseOver) {
+        painter->fillRect(rect, pal.color(QPalette::Mid));
+    }
+
+    QColor textColor = (option.state & QStyle::State_Selected)
+            ? pal.color(QPalette::HighlightedText) : pal.color(QPalette::Text);
+
+    // Разделитель между строками
+    painter->setPen(pal.color(QPalette::Mid));
+    painter->drawLine(rect.bottomLeft(), rect.bottomRight());
+
+    QRect content = rect.adjusted(PADDING, 0, -PADDING, 0);
+    bool hasData = index.data(FavoritesModel::HasDataRole).toBool();
+
+    if (hasData) {
+        QRect iconRect(content.left(), content.center().y() - ICON_SIZE / 2, ICON_SIZE, ICON_SIZE);
+        int code = index.data(FavoritesModel::WeatherCodeRole).toInt();
+        WeatherIconAtlas::instance().draw(painter, iconRect, WeatherIconAtlas::conditionForCode(code));
+    }
+    content.setLeft(content.left() + ICON_SIZE + PADDING);
+
+    QString tempText;
+    if (hasData) {
+        double temp = index.data(FavoritesModel::TemperatureRole).toDouble();
+        if (!m_isCelsius) temp = temp * 9.0 / 5.0 + 32.0;
+        tempText = QString::number(temp, 'f', 0) + (m_isCelsius ? "°C" : "°F");
+    }
+
+    QFont tempFont = option.font;
+    tempFont.setBold(true);
+    QFontMetrics tempMetrics(tempFont);
+    int tempWidth = tempMetrics.horizontalAdvance("-00°C");
+
+    QRect tempRect(content.right() - tempWidth, content.top(), tempWidth, content.height());
+    QRect sparkRect(tempRect.left() - PADDING - SPARKLINE_WIDTH, content.top() + 12,
+                    SPARKLINE_WIDTH, content.height() - 24);
+    QRect cityRect(content.left(), content.top(), sparkRect.left() - PADDING - content.left(), content.height());
+
+    painter->setPen(textColor);
+    painter->setFont(option.font);
+    QString city = index.data(FavoritesModel::CityRole).toString();
+    painter->drawText(cityRect, Qt::AlignVCenter | Qt::AlignLeft,
+                      option.fontMetrics.elidedText(city, Qt::ElideRight, cityRect.width()));
+
+    if (hasData) {
+        QVector<float> sparkline = index.data(FavoritesModel::SparklineRole).value<QVector<float>>();
+        QColor lineColor = (option.state & QStyle::State_Selected)
+                ? textColor : pal.color(QPalette::Highlight).lighter(140);
+        paintSparkline(painter, sparkRect, sparkline, lineColor);
+
+        painter->setPen(textColor);
+        painter->setFont(tempFont);
+        painter->drawText(tempRect, Qt::AlignVCenter | Qt::AlignRight, tempText);
+    }
+
+    painter->restore();
+}
+
+void FavoritesDelegate::paintSparkline(QPainter *painter, const QRect &rect,
+                                       const QVector<float> &values, const QColor &color) const
+{
+    if (values.size() < 2 || rect.width() <= 0 || rect.height() <= 0) return;
+
+    auto range = std::minmax_element(values.constBegin(), values.constEnd());
+    float minValue = *range.first;
+    float span = qMax(*range.second - minValue, 0.1f);
+
+    QPainterPath path;
+    qreal step = qreal(rect.width()) / (values.size() - 1);
+    for (int i = 0; i < values.size(); ++i) {
+        QPointF point(rect.left() + i * step,
+                      rect.bottom() - (values[i] - minValue) / span * rect.height());
+        if (i == 0) path.moveTo(point);
+        else path.lineTo(point);
+    }
+
+    painter->setRenderHint(QPainter::Antialiasing, true);
+    painter->setPen(QPen(color, 1.5));
+    painter->setBrush(Qt::NoBrush);
+    painter->drawPath(path);
+}
@@ -0,0 +1,27 @@
+#ifndef FAVORITESDELEGATE_H
+#define FAVORITESDELEGATE_H
+
+#include <QStyledItemDelegate>
+
+// Строка избранного: иконка, город, температура и спарклайн на ближайшие часы
+class FavoritesDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit FavoritesDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option,
+               const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+    void setCelsius(bool celsius) { m_isCelsius = celsius; }
+
+private:
+    void paintSparkline(QPainter *painter, const QRect &rect,
+                        const QVector<float> &values, const QColor &color) const;
+
+    bool m_isCelsius;
+};
+
+#endif // FAVORITESDELEGATE_H
@@ -0,0 +1,212 @@
+#include "favoritesmodel.h"
+#include <algorithm>
+
+FavoritesModel::FavoritesModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_flushTimer(new QTimer(this))
+{
+    // Ответы массового обновления приходят пачками - собираем их в диапазоны
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(50);
+    connect(m_flushTimer, &QTimer::timeout, this, &FavoritesModel::flushChanges);
+}
+
+int FavoritesModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_entries.size();
+}
+
+QVariant FavoritesModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_entries.size()) {
+        return QVariant();
+    }
+
+    const FavoriteEntry &entry = m_entries[index.row()];
+    switch (role) {
+    case Qt::DisplayRole:
+    case CityRole:
+        return entry.city;
+    case HasDataRole:
+        return entry.hasData;
+    case TemperatureRole:
+        return entry.temp;
+    case WeatherCodeRole:
+        return entry.weatherCode;
+    case SparklineRole:
+        return QVariant::fromValue(entry.sparkline);
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> FavoritesModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[CityRole] = "city";
+    roles[HasDataRole] = "hasData";
+    roles[TemperatureRole] = "temperature";
+    roles[WeatherCodeRole] = "weatherCode";
+    roles[SparklineRole] = "sparkline";
+    return roles;
+}
+
+void FavoritesModel::setCities(const QStringList &cities)
+{
+    beginResetModel();
+    m_entries.clear();
+    m_entries.reserve(cities.size());
+    for (const QString &city : cities) {
+        FavoriteEntry entry;
+        entry.city = city;
+        entry.hasData = false;
+        entry.temp = 0;
+        entry.weatherCode = 0;
+        m_entries.append(entry);
+    }
+    m_dirtyRows.clear();
+    rebuildRows(0);
+    endResetModel();
+}
+
+QStringList FavoritesModel::cities() const
+{
+    QStringList result;
+    result.reserve(m_entries.size());
+    for (const FavoriteEntry &entry : m_entries) {
+        result.append(entry.city);
+    }
+    return result;
+}
+
+QString FavoritesModel::cityAt(int row) const
+{
+    return (row >= 0 && row < m_entries.size()) ? m_entries[row].city : QString();
+}
+
+void FavoritesModel::append(const QString &city)
+{
+    if (m_rows.contains(city)) return;
+
+    int row = m_entries.size();
+    beginInsertRows(QModelIndex(), row, row);
+    FavoriteEntry entry;
+    entry.city = city;
+    entry.hasData = false;
+    entry.temp = 0;
+    entry.weatherCode = 0;
+    m_entries.append(entry);
+    m_rows.insert(city, row);
+    endInsertRows();
+}
+
+void FavoritesModel::appendEntries(const QVector<FavoriteEntry> &entries)
+{
+    // Одна вставка на всю страницу загруженных строк
+    QVector<FavoriteEntry> fresh;
+    fresh.reserve(entries.size());
+    for (const FavoriteEntry &entry : entries) {
+        if (!m_rows.contains(entry.city)) {
+            fresh.append(entry);
+        }
+    }
+    if (fresh.isEmpty()) return;
+
+    int first = m_entries.size();
+    beginInsertRows(QModelIndex(), first, first + fresh.size() - 1);
+    for (const FavoriteEntry &entry : fresh) {
+        m_rows.insert(entry.city, m_entries.size());
+        m_entries.append(entry);
+    }
+    endInsertRows();
+}
+
+bool FavoritesModel::remove(const QString &city)
+{
+    auto it = m_rows.constFind(city);
+    if (it == m_rows.constEnd()) return false;
+
+    int row = it.value();
+    beginRemoveRows(QModelIndex(), row, row);
+    m_entries.remove(row);
+    rebuildRows(row);
+    endRemoveRows();
+
+    // Номера отложенных строк после удалённой сдвинулись
+    QSet<int> shifted;
+    for (int dirty : m_dirtyRows) {
+        if (dirty < row) shifted.insert(dirty);
+        else if (dirty > row) shifted.insert(dirty - 1);
+    }
+    m_dirtyRows = shifted;
+    return true;
+}
+
+void FavoritesModel::updateObservation(const QString &city, double temp, int weatherCode,
+                                       const QVector<float> &sparkline)
+{
+    auto it = m_rows.constFind(city);
+    if (it == m_rows.constEnd()) return;
+
+    FavoriteEntry &entry = m_entries[it.value()];
+    entry.hasData = true;
+    entry.temp = temp;
+    entry.weatherCode = weatherCode;
+    entry.sparkline = sparkline;
+
+    m_dirtyRows.insert(it.value());
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+void FavoritesModel::refreshAll()
+{
+    // Смена единиц измерения: перерисовать текст, но не пересоздавать строки
+    if (m_entries.isEmpty()) return;
+    emit dataChanged(index(0), index(m_entries.size() - 1), QVector<int>() << TemperatureRole);
+}
+
+void FavoritesModel::flushChanges()
+{
+    if (m_dirtyRows.isEmpty()) return;
+
+    QVector<int> rows;
+    rows.reserve(m_dirtyRows.size());
+    for (int row : m_dirtyRows) {
+        rows.append(row);
+    }
+    std::sort(rows.begin(), rows.end());
+    m_dirtyRows.clear();
+
+    const QVector<int> roles = QVector<int>() << HasDataRole << TemperatureRole
+                                              << WeatherCodeRole << SparklineRole;
+
+    // Одно уведомление на каждый непрерывный диапазон изменённых строк
+    int first = rows[0];
+    int last = first;
+    for (int i = 1; i < rows.size(); ++i) {
+        if (rows[i] == last + 1) {
+            last = rows[i];
+            continue;
+        }
+        emit dataChanged(index(first), index(last), roles);
+        first = last = rows[i];
+    }
+    emit dataChanged(index(first), index(last), roles);
+}
+
+void FavoritesModel::rebuildRows(int fromRow)
+{
+    if (fromRow == 0) {
+        m_rows.clear();
+        m_rows.reserve(m_entries.size());
+    }
+    for (auto it = m_rows.begin(); it != m_rows.end(); ) {
+        if (it.value() >= fromRow) it = m_rows.erase(it);
+        else ++it;
+    }
+    for (int i = fromRow; i < m_entries.size(); ++i) {
+        m_rows.insert(m_entries[i].city, i);
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef FAVORITESMODEL_H
+#define FAVORITESMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+
+struct FavoriteEntry {
+    QString city;
+    bool hasData;
+    double temp;
+    int weatherCode;
+    QVector<float> sparkline; // температура на ближайшие часы
+};
+
+// Модель избранного: строки вставляются и удаляются по одной,
+// обновления погоды копятся и уходят одним dataChanged на непрерывный диапазон
+class FavoritesModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        CityRole = Qt::UserRole + 1,
+        HasDataRole,
+        TemperatureRole,
+        WeatherCodeRole,
+        SparklineRole
+    };
+
+    explicit FavoritesModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    void setCities(const QStringList &cities);
+    QStringList cities() const;
+    bool contains(const QString &city) const { return m_rows.contains(city); }
+    QString cityAt(int row) const;
+
+    void append(const QString &city);
+    void appendEntries(const QVector<FavoriteEntry> &entries);
+    bool remove(const QString &city);
+
+    void updateObservation(const QString &city, double temp, int weatherCode,
+                           const QVector<float> &sparkline);
+    void refreshAll();
+
+private slots:
+    void flushChanges();
+
+private:
+    void rebuildRows(int fromRow);
+
+    QVector<FavoriteEntry> m_entries;
+    QHash<QString, int> m_rows;
+    QSet<int> m_dirtyRows;
+    QTimer *m_flushTimer;
+};
+
+#endif // FAVORITESMODEL_H
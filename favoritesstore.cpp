@@ -0,0 +1,299 @@
+#include "favoritesstore.h"
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStandardPaths>
+#include <QDir>
+#include <QDebug>
+
+namespace {
+const int FLUSH_DELAY_MS = 500;
+const int LOAD_PAGE_SIZE = 200;
+}
+
+FavoritesStoreWorker::FavoritesStoreWorker(const QString &path)
+    : m_path(path)
+    , m_connectionName("favorites-store")
+    , m_isOpen(false)
+{
+}
+
+FavoritesStoreWorker::~FavoritesStoreWorker()
+{
+    if (m_isOpen) {
+        QSqlDatabase::database(m_connectionName).close();
+    }
+    QSqlDatabase::removeDatabase(m_connectionName);
+}
+
+void FavoritesStoreWorker::open()
+{
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+    db.setDatabaseName(m_path);
+    if (!db.open()) {
+        qWarning() << "Failed to open favorites store:" << db.lastError().text();
+        emit opened(0);
+        return;
+    }
+
+    QSqlQuery query(db);
+    // WAL: запись не блокирует чтение, fsync реже
+    query.exec("PRAGMA journal_mode=WAL");
+    query.exec("PRAGMA synchronous=NORMAL");
+    if (!query.exec("CREATE TABLE IF NOT EXISTS favorites ("
+                    "city TEXT PRIMARY KEY, "
+                    "position INTEGER NOT NULL DEFAULT 0, "
+                    "lat REAL, lon REAL, "
+                    "temp REAL, weather_code INTEGER, observed_at INTEGER)")) {
+        qWarning() << "Failed to create favorites table:" << query.lastError().text();
+        emit opened(0);
+        return;
+    }
+    query.exec("CREATE INDEX IF NOT EXISTS favorites_position ON favorites(position)");
+
+    m_isOpen = true;
+
+    int nextPosition = 0;
+    if (query.exec("SELECT MAX(position) FROM favorites") && query.next() && !query.value(0).isNull()) {
+        nextPosition = query.value(0).toInt() + 1;
+    }
+    qDebug() << "Favorites store opened:" << m_path << "next position:" << nextPosition;
+    emit opened(nextPosition);
+}
+
+void FavoritesStoreWorker::load(int pageSize)
+{
+    QList<StoredFavorite> page;
+    if (!m_isOpen) {
+        emit pageLoaded(page, true);
+        return;
+    }
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    query.setForwardOnly(true);
+    query.exec("SELECT city, position, lat, lon, temp, weather_code, observed_at "
+               "FROM favorites ORDER BY position");
+
+    while (query.next()) {
+        StoredFavorite fav;
+        fav.city = query.value(0).toString();
+        fav.position = query.value(1).toInt();
+        fav.hasCoordinates = !query.value(2).isNull() && !query.value(3).isNull();
+        fav.lat = query.value(2).toDouble();
+        fav.lon = query.value(3).toDouble();
+        fav.hasObservation = !query.value(6).isNull();
+        fav.temp = query.value(4).toDouble();
+        fav.weatherCode = query.value(5).toInt();
+        fav.observedAt = query.value(6).toLongLong();
+        page.append(fav);
+
+        // Страницами: GUI получает первые строки, не дожидаясь всего списка
+        if (page.size() >= pageSize) {
+            emit pageLoaded(page, false);
+            page.clear();
+        }
+    }
+
+    emit pageLoaded(page, true);
+}
+
+void FavoritesStoreWorker::apply(const QList<FavoriteChange> &changes)
+{
+    if (!m_isOpen || changes.isEmpty()) return;
+
+    QSqlDatabase db = QSqlDatabase::database(m_connectionName);
+    db.transaction();
+
+    QSqlQuery insert(db);
+    insert.prepare("INSERT OR IGNORE INTO favorites(city, position) VALUES(?, ?)");
+    QSqlQuery remove(db);
+    remove.prepare("DELETE FROM favorites WHERE city = ?");
+    QSqlQuery position(db);
+    position.prepare("UPDATE favorites SET position = ? WHERE city = ?");
+    QSqlQuery coordinates(db);
+    coordinates.prepare("UPDATE favorites SET lat = ?, lon = ? WHERE city = ?");
+    QSqlQuery observation(db);
+    observation.prepare("UPDATE favorites SET temp = ?, weather_code = ?, observed_at = ? WHERE city = ?");
+
+    for (const FavoriteChange &change : changes) {
+        if (change.removed) {
+            remove.addBindValue(change.city);
+            remove.exec();
+            continue;
+        }
+
+        // Строку создаёт только добавление в избранное. Координаты и показания
+        // обновляют существующую: запоздавшая запись по удалённому городу его не вернёт
+        if (change.hasPosition) {
+            insert.addBindValue(change.city);
+            insert.addBindValue(change.position);
+            insert.exec();
+
+            position.addBindValue(change.position);
+            position.addBindValue(change.city);
+            position.exec();
+        }
+        if (change.hasCoordinates) {
+            coordinates.addBindValue(change.lat);
+            coordinates.addBindValue(change.lon);
+            coordinates.addBindValue(change.city);
+            coordinates.exec();
+        }
+        if (change.hasObservation) {
+            observation.addBindValue(change.temp);
+            observation.addBindValue(change.weatherCode);
+            observation.addBindValue(change.observedAt);
+            observation.addBindValue(change.city);
+            observation.exec();
+        }
+    }
+
+    if (!db.commit()) {
+        qWarning() << "Favorites store commit failed:" << db.lastError().text();
+    }
+}
+
+FavoritesStore::FavoritesStore(QObject *parent)
+    : QObject(parent)
+    , m_worker(nullptr)
+    , m_flushTimer(new QTimer(this))
+    , m_nextPosition(0)
+    , m_positionsKnown(false)
+{
+    qRegisterMetaType<StoredFavorite>("StoredFavorite");
+    qRegisterMetaType<FavoriteChange>("FavoriteChange");
+    qRegisterMetaType<QList<StoredFavorite>>("QList<StoredFavorite>");
+    qRegisterMetaType<QList<FavoriteChange>>("QList<FavoriteChange>");
+
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+
+    m_worker = new FavoritesStoreWorker(dir + "/favorites.sqlite");
+    m_worker->moveToThread(&m_thread);
+    connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(m_worker, &FavoritesStoreWorker::opened, this, [this](int nextPosition) {
+        // Добавленные до открытия (перенос из настроек, ранний add) получали позиции с нуля -
+        // сдвигаем их за уже сохранённые, чтобы не было повторов
+        for (FavoriteChange &change : m_pending) {
+            if (change.hasPosition) {
+                change.position += nextPosition;
+            }
+        }
+        m_nextPosition += nextPosition;
+        m_positionsKnown = true;
+        if (!m_pending.isEmpty()) {
+            scheduleFlush();
+        }
+    });
+    connect(m_worker, &FavoritesStoreWorker::pageLoaded, this,
+            [this](const QList<StoredFavorite> &page, bool last) {
+        emit pageLoaded(page, last);
+    });
+    m_thread.start();
+
+    QMetaObject::invokeMethod(m_worker, "open", Qt::QueuedConnection);
+
+    // Несколько изменений подряд (массовое обновление избранного) уходят одной транзакцией
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(FLUSH_DELAY_MS);
+    connect(m_flushTimer, &QTimer::timeout, this, &FavoritesStore::flush);
+}
+
+FavoritesStore::~FavoritesStore()
+{
+    // Последнюю пачку пишем синхронно: после quit() очередь потока не разбирается
+    flushWith(Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+}
+
+void FavoritesStore::load()
+{
+    QMetaObject::invokeMethod(m_worker, "load", Qt::QueuedConnection, Q_ARG(int, LOAD_PAGE_SIZE));
+}
+
+FavoriteChange &FavoritesStore::pending(const QString &city)
+{
+    auto it = m_pending.find(city);
+    if (it == m_pending.end()) {
+        FavoriteChange change;
+        change.city = city;
+        change.removed = false;
+        change.hasPosition = false;
+        change.position = 0;
+        change.hasCoordinates = false;
+        change.lat = 0;
+        change.lon = 0;
+        change.hasObservation = false;
+        change.temp = 0;
+        change.weatherCode = 0;
+        change.observedAt = 0;
+        it = m_pending.insert(city, change);
+    }
+    return it.value();
+}
+
+void FavoritesStore::scheduleFlush()
+{
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+void FavoritesStore::addFavorite(const QString &city)
+{
+    FavoriteChange &change = pending(city);
+    change.removed = false;
+    change.hasPosition = true;
+    change.position = m_nextPosition++;
+    scheduleFlush();
+}
+
+void FavoritesStore::removeFavorite(const QString &city)
+{
+    FavoriteChange &change = pending(city);
+    change.removed = true;
+    change.hasPosition = false;
+    change.hasCoordinates = false;
+    change.hasObservation = false;
+    scheduleFlush();
+}
+
+void FavoritesStore::saveCoordinates(const QString &city, double lat, double lon)
+{
+    FavoriteChange &change = pending(city);
+    if (change.removed) return;
+    change.hasCoordinates = true;
+    change.lat = lat;
+    change.lon = lon;
+    scheduleFlush();
+}
+
+void FavoritesStore::saveObservation(const QString &city, double temp, int weatherCode, qint64 observedAt)
+{
+    FavoriteChange &change = pending(city);
+    if (change.removed) return;
+    change.hasObservation = true;
+    change.temp = temp;
+    change.weatherCode = weatherCode;
+    change.observedAt = observedAt;
+    scheduleFlush();
+}
+
+void FavoritesStore::flush()
+{
+    flushWith(Qt::QueuedConnection);
+}
+
+void FavoritesStore::flushWith(Qt::ConnectionType type)
+{
+    m_flushTimer->stop();
+    if (m_pending.isEmpty()) return;
+    // Без базовой позиции новые строки получили бы повторяющиеся номера; запишем после open()
+    if (!m_positionsKnown && type != Qt::BlockingQueuedConnection) return;
+
+    QList<FavoriteChange> changes = m_pending.values();
+    m_pending.clear();
+
+    QMetaObject::invokeMethod(m_worker, "apply", type, Q_ARG(QList<FavoriteChange>, changes));
+}
@@ -0,0 +1,103 @@
+#ifndef FAVORITESSTORE_H
+#define FAVORITESSTORE_H
+
+#include <QObject>
+#include <QThread>
+#include <QTimer>
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+
+struct StoredFavorite {
+    QString city;
+    int position;
+    bool hasCoordinates;
+    double lat;
+    double lon;
+    bool hasObservation;
+    double temp;
+    int weatherCode;
+    qint64 observedAt;
+};
+
+// Накопленное изменение одного избранного города: пишутся только изменившиеся поля
+struct FavoriteChange {
+    QString city;
+    bool removed;
+    bool hasPosition;
+    int position;
+    bool hasCoordinates;
+    double lat;
+    double lon;
+    bool hasObservation;
+    double temp;
+    int weatherCode;
+    qint64 observedAt;
+};
+
+Q_DECLARE_METATYPE(StoredFavorite)
+Q_DECLARE_METATYPE(FavoriteChange)
+
+// Работает в отдельном потоке и владеет соединением с SQLite
+class FavoritesStoreWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FavoritesStoreWorker(const QString &path);
+    ~FavoritesStoreWorker();
+
+public slots:
+    void open();
+    void load(int pageSize);
+    void apply(const QList<FavoriteChange> &changes);
+
+signals:
+    // Следующая свободная позиция: MAX(position) + 1 или 0 для пустой таблицы
+    void opened(int nextPosition);
+    void pageLoaded(const QList<StoredFavorite> &page, bool last);
+
+private:
+    QString m_path;
+    QString m_connectionName;
+    bool m_isOpen;
+};
+
+// Хранилище избранного: изменения копятся в памяти и пачкой
+// записываются в SQLite вне GUI-потока
+class FavoritesStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FavoritesStore(QObject *parent = nullptr);
+    ~FavoritesStore();
+
+    void load();
+    int nextPosition() const { return m_nextPosition; }
+
+    void addFavorite(const QString &city);
+    void removeFavorite(const QString &city);
+    void saveCoordinates(const QString &city, double lat, double lon);
+    void saveObservation(const QString &city, double temp, int weatherCode, qint64 observedAt);
+
+    void flush();
+
+signals:
+    void pageLoaded(const QList<StoredFavorite> &page, bool last);
+
+private:
+    FavoriteChange &pending(const QString &city);
+    void scheduleFlush();
+    void flushWith(Qt::ConnectionType type);
+
+    QThread m_thread;
+    FavoritesStoreWorker *m_worker;
+    QHash<QString, FavoriteChange> m_pending;
+    QTimer *m_flushTimer;
+    int m_nextPosition;
+    // Пока позиции из базы не известны, изменения копятся и не отправляются
+    bool m_positionsKnown;
+};
+
+#endif // FAVORITESSTORE_H
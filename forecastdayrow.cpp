@@ -0,0 +1,117 @@
+#include "forecastdayrow.h"
+#include "weathericons.h"
+#include "translator.h"
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QLabel>
+#include <QPainter>
+#include <QMouseEvent>
+#include <QDateTime>
+#include <QtMath>
+
+namespace {
+const int HOUR_WIDTH = 34;
+const int ICON_SIZE = 20;
+}
+
+HourlyStrip::HourlyStrip(QWidget *parent)
+    : QWidget(parent)
+    , m_isCelsius(true)
+{
+    setMinimumHeight(72);
+}
+
+void HourlyStrip::setPoints(const QVector<HourlyPoint> &points, bool celsius)
+{
+    m_points = points;
+    m_isCelsius = celsius;
+    // Узкое окно показывает каждый второй или третий час
+    setMinimumWidth(HOUR_WIDTH * 8);
+    update();
+}
+
+void HourlyStrip::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+    if (m_points.isEmpty()) return;
+
+    QPainter painter(this);
+    painter.setPen(palette().color(QPalette::Text));
+
+    int stride = qMax(1, qCeil(double(m_points.size()) * HOUR_WIDTH / qMax(width(), 1)));
+    int columns = (m_points.size() + stride - 1) / stride;
+    double columnWidth = double(width()) / columns;
+
+    for (int c = 0; c < columns; ++c) {
+        const HourlyPoint &point = m_points[c * stride];
+        QRect column(int(c * columnWidth), 0, int(columnWidth), height());
+
+        painter.drawText(QRect(column.left(), 0, column.width(), 16), Qt::AlignCenter,
+                         QDateTime::fromSecsSinceEpoch(point.time, Qt::UTC).toString("HH"));
+
+        QRect iconRect(column.center().x() - ICON_SIZE / 2, 18, ICON_SIZE, ICON_SIZE);
+        WeatherIconAtlas::instance().draw(&painter, iconRect,
+                                          WeatherIconAtlas::conditionForCode(point.weatherCode));
+
+        if (!qIsNaN(point.temp)) {
+            float temp = m_isCelsius ? point.temp : point.temp * 9.0f / 5.0f + 32.0f;
+            painter.drawText(QRect(column.left(), 40, column.width(), 16), Qt::AlignCenter,
+                             QString::number(temp, 'f', 0) + "°");
+        }
+        if (!qIsNaN(point.precipitation) && point.precipitation > 0) {
+            painter.drawText(QRect(column.left(), 56, column.width(), 16), Qt::AlignCenter,
+                             QString::number(point.precipitation, 'f', 0) + "%");
+        }
+    }
+}
+
+ForecastDayRow::ForecastDayRow(qint64 day, QWidget *parent)
+    : QFrame(parent)
+    , m_day(day)
+    , m_expanded(false)
+    , m_summaryLayout(new QHBoxLayout())
+    , m_loadingLabel(new QLabel(TR("Forecast/loading_hours"), this))
+    , m_strip(new HourlyStrip(this))
+{
+    setFrameShape(QFrame::StyledPanel);
+    setCursor(Qt::PointingHandCursor);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(m_summaryLayout);
+    layout->addWidget(m_loadingLabel);
+    layout->addWidget(m_strip);
+
+    m_loadingLabel->hide();
+    m_strip->hide();
+}
+
+void ForecastDayRow::setExpanded(bool expanded)
+{
+    m_expanded = expanded;
+    if (!expanded) {
+        m_loadingLabel->hide();
+        m_strip->hide();
+    }
+}
+
+void ForecastDayRow::setLoading()
+{
+    m_strip->hide();
+    m_loadingLabel->setVisible(m_expanded);
+}
+
+void ForecastDayRow::setDetail(const QVector<HourlyPoint> &points, bool celsius)
+{
+    m_strip->setPoints(points, celsius);
+    m_loadingLabel->hide();
+    m_strip->setVisible(m_expanded);
+}
+
+void ForecastDayRow::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        setExpanded(!m_expanded);
+        emit toggled(m_day, m_expanded);
+    }
+    QFrame::mouseReleaseEvent(event);
+}
@@ -0,0 +1,58 @@
+#ifndef FORECASTDAYROW_H
+#define FORECASTDAYROW_H
+
+#include <QFrame>
+#include "forecastdetail.h"
+
+class QHBoxLayout;
+class QLabel;
+
+// Почасовая полоса раскрытого дня
+class HourlyStrip : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit HourlyStrip(QWidget *parent = nullptr);
+
+    void setPoints(const QVector<HourlyPoint> &points, bool celsius);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    QVector<HourlyPoint> m_points;
+    bool m_isCelsius;
+};
+
+// Строка дня в прогнозе: сводка всегда видна, почасовая детализация - по щелчку
+class ForecastDayRow : public QFrame
+{
+    Q_OBJECT
+
+public:
+    ForecastDayRow(qint64 day, QWidget *parent = nullptr);
+
+    qint64 day() const { return m_day; }
+    QHBoxLayout *summaryLayout() const { return m_summaryLayout; }
+
+    bool isExpanded() const { return m_expanded; }
+    void setExpanded(bool expanded);
+    void setLoading();
+    void setDetail(const QVector<HourlyPoint> &points, bool celsius);
+
+signals:
+    void toggled(qint64 day, bool expanded);
+
+protected:
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+private:
+    qint64 m_day;
+    bool m_expanded;
+    QHBoxLayout *m_summaryLayout;
+    QLabel *m_loadingLabel;
+    HourlyStrip *m_strip;
+};
+
+#endif // FORECASTDAYROW_H
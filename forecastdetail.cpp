@@ -0,0 +1,156 @@
+#include "forecastdetail.h"
+#include <QNetworkReply>
+#include <QUrlQuery>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDateTime>
+#include <QtMath>
+#include <QDebug>
+
+namespace {
+const qint64 DETAIL_TTL_MS = 30 * 60 * 1000;
+const int MAX_CACHED_DAYS = 96;
+}
+
+ForecastDetailLoader::ForecastDetailLoader(RequestScheduler *scheduler, const QString &apiUrl, QObject *parent)
+    : QObject(parent)
+    , m_scheduler(scheduler)
+    , m_apiUrl(apiUrl)
+    , m_locationId(0xffffffffu)
+    , m_point()
+    , m_fetched(0)
+    , m_cancelled(0)
+{
+}
+
+void ForecastDetailLoader::setLocation(quint32 locationId, const GeoPoint &point)
+{
+    if (locationId == m_locationId) {
+        m_point = point;
+        return;
+    }
+
+    cancelAll();
+    m_locationId = locationId;
+    m_point = point;
+}
+
+bool ForecastDetailLoader::cached(qint64 day, QVector<HourlyPoint> *points) const
+{
+    auto it = m_cache.constFind(qMakePair(m_locationId, day));
+    if (it == m_cache.constEnd()) return false;
+    if (QDateTime::currentMSecsSinceEpoch() - it.value().fetchedAt > DETAIL_TTL_MS) return false;
+
+    *points = it.value().points;
+    return true;
+}
+
+bool ForecastDetailLoader::isLoading(qint64 day) const
+{
+    return m_inFlight.contains(day);
+}
+
+void ForecastDetailLoader::load(qint64 day)
+{
+    if (isLoading(day)) return;
+
+    // Местная полночь записана как UTC - дата берётся в UTC
+    QString date = QDateTime::fromSecsSinceEpoch(day, Qt::UTC).date().toString(Qt::ISODate);
+
+    QUrl url(m_apiUrl);
+    QUrlQuery query;
+    query.addQueryItem("latitude", QString::number(m_point.lat));
+    query.addQueryItem("longitude", QString::number(m_point.lon));
+    query.addQueryItem("hourly", "temperature_2m,precipitation_probability,weather_code");
+    query.addQueryItem("start_date", date);
+    query.addQueryItem("end_date", date);
+    query.addQueryItem("timezone", "auto");
+    query.addQueryItem("timeformat", "unixtime");
+    url.setQuery(query);
+
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::UserAgentHeader, "SimpleWeather/1.0");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    request.setTransferTimeout(10000);
+#endif
+
+    RequestScheduler::Ticket ticket = m_scheduler->get(request, RequestScheduler::CurrentCity,
+                                                       QString::number(m_locationId), this,
+                                                       [this, day](QNetworkReply *reply) {
+        onReplyFinished(day, reply);
+    });
+    m_inFlight.insert(day, ticket);
+    ++m_fetched;
+
+    qDebug() << "Hourly detail requested:" << date;
+}
+
+void ForecastDetailLoader::cancel(qint64 day)
+{
+    RequestScheduler::Ticket ticket = m_inFlight.take(day);
+    if (ticket) {
+        ++m_cancelled;
+        qDebug() << "Hourly detail cancelled:" << QDateTime::fromSecsSinceEpoch(day, Qt::UTC).date()
+                 << "fetched:" << m_fetched << "cancelled:" << m_cancelled;
+        m_scheduler->cancel(ticket);
+    }
+}
+
+void ForecastDetailLoader::cancelAll()
+{
+    const QList<qint64> days = m_inFlight.keys();
+    for (qint64 day : days) {
+        cancel(day);
+    }
+}
+
+void ForecastDetailLoader::onReplyFinished(qint64 day, QNetworkReply *reply)
+{
+    // Отменённая загрузка колбэк не получает
+    m_inFlight.remove(day);
+
+    if (reply->error() != QNetworkReply::NoError) {
+        qDebug() << "Hourly detail error:" << reply->errorString();
+        return;
+    }
+
+    QJsonObject obj = QJsonDocument::fromJson(reply->readAll()).object();
+    qint64 utcOffset = qint64(obj["utc_offset_seconds"].toDouble());
+    const QJsonObject hourly = obj["hourly"].toObject();
+    const QJsonArray times = hourly["time"].toArray();
+    const QJsonArray temps = hourly["temperature_2m"].toArray();
+    const QJsonArray precipitation = hourly["precipitation_probability"].toArray();
+    const QJsonArray codes = hourly["weather_code"].toArray();
+
+    QVector<HourlyPoint> points;
+    points.reserve(times.size());
+    for (int i = 0; i < times.size(); ++i) {
+        HourlyPoint point;
+        point.time = qint64(times[i].toDouble()) + utcOffset;
+        point.temp = temps[i].isDouble() ? float(temps[i].toDouble()) : float(qQNaN());
+        point.precipitation = precipitation[i].isDouble() ? float(precipitation[i].toDouble()) : float(qQNaN());
+        point.weatherCode = quint8(codes[i].toInt());
+        points.append(point);
+    }
+
+    Entry entry;
+    entry.points = points;
+    entry.fetchedAt = QDateTime::currentMSecsSinceEpoch();
+    m_cache.insert(qMakePair(m_locationId, day), entry);
+    trimCache();
+
+    emit loaded(day, points);
+}
+
+void ForecastDetailLoader::trimCache()
+{
+    // Выбрасываем самые старые дни, пока кэш больше предела
+    while (m_cache.size() > MAX_CACHED_DAYS) {
+        auto oldest = m_cache.begin();
+        for (auto it = m_cache.begin(); it != m_cache.end(); ++it) {
+            if (it.value().fetchedAt < oldest.value().fetchedAt) oldest = it;
+        }
+        m_cache.erase(oldest);
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef FORECASTDETAIL_H
+#define FORECASTDETAIL_H
+
+#include <QObject>
+#include <QHash>
+#include <QPair>
+#include <QVector>
+#include "cityindex.h"
+#include "requestscheduler.h"
+
+class QNetworkReply;
+
+// Час почасовой детализации дня. time - местное время, записанное как UTC
+struct HourlyPoint {
+    qint64 time;
+    float temp;
+    float precipitation;    // вероятность осадков, %
+    quint8 weatherCode;
+};
+
+// Почасовые данные дня загружаются только по запросу (строка раскрыта и видна)
+// и кэшируются по месту и дню. Невидимые загрузки отменяются.
+class ForecastDetailLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    ForecastDetailLoader(RequestScheduler *scheduler, const QString &apiUrl, QObject *parent = nullptr);
+
+    void setLocation(quint32 locationId, const GeoPoint &point);
+
+    bool cached(qint64 day, QVector<HourlyPoint> *points) const;
+    bool isLoading(qint64 day) const;
+    void load(qint64 day);
+    void cancel(qint64 day);
+    void cancelAll();
+
+signals:
+    void loaded(qint64 day, const QVector<HourlyPoint> &points);
+
+private:
+    typedef QPair<quint32, qint64> Key;
+
+    struct Entry {
+        QVector<HourlyPoint> points;
+        qint64 fetchedAt;
+    };
+
+    void onReplyFinished(qint64 day, QNetworkReply *reply);
+    void trimCache();
+
+    RequestScheduler *m_scheduler;
+    QString m_apiUrl;
+    quint32 m_locationId;
+    GeoPoint m_point;
+
+    QHash<Key, Entry> m_cache;
+    QHash<qint64, RequestScheduler::Ticket> m_inFlight;
+
+    int m_fetched;
+    int m_cancelled;
+};
+
+#endif // FORECASTDETAIL_H
@@ -0,0 +1,249 @@
+#include "heatmapdialog.h"
+#include "translator.h"
+#include <QComboBox>
+#include <QLabel>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPainter>
+#include <QMouseEvent>
+#include <QKeyEvent>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QtMath>
+#include <QDebug>
+
+namespace {
+const int GRID_ROWS = 12;
+const int GRID_COLS = 16;
+const int CELL_PIXELS = 32;
+const int LEGEND_HEIGHT = 28;
+const int IMAGE_CACHE_KB = 64 * 1024;
+}
+
+HeatmapView::HeatmapView(QWidget *parent)
+    : QWidget(parent)
+    , m_marker(0.5, 0.5)
+    , m_field(RegionGrid::Temperature)
+    , m_isCelsius(true)
+{
+    setMinimumSize(GRID_COLS * CELL_PIXELS, GRID_ROWS * CELL_PIXELS + LEGEND_HEIGHT);
+    setCursor(Qt::OpenHandCursor);
+}
+
+void HeatmapView::setImage(const QImage &image)
+{
+    m_image = image;
+    update();
+}
+
+void HeatmapView::setLegend(RegionGrid::Field field, bool celsius)
+{
+    m_field = field;
+    m_isCelsius = celsius;
+    update();
+}
+
+void HeatmapView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+
+    QPainter painter(this);
+    QRect map = rect().adjusted(0, 0, 0, -LEGEND_HEIGHT);
+    painter.fillRect(rect(), palette().color(QPalette::AlternateBase));
+
+    if (!m_image.isNull()) {
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.drawImage(map, m_image);
+    }
+
+    // Отметка города
+    QPointF marker(map.left() + m_marker.x() * map.width(), map.top() + m_marker.y() * map.height());
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(Qt::black, 2));
+    painter.setBrush(Qt::white);
+    painter.drawEllipse(marker, 5, 5);
+
+    // Шкала: градиент по значениям и подписи по краям
+    QRect legend(map.left() + 40, map.bottom() + 8, map.width() - 80, LEGEND_HEIGHT - 14);
+    float low = m_field == RegionGrid::Temperature ? -30.0f : 0.0f;
+    float high = m_field == RegionGrid::Temperature ? 40.0f : 10.0f;
+    for (int x = 0; x < legend.width(); ++x) {
+        float value = low + (high - low) * x / qMax(1, legend.width() - 1);
+        painter.setPen(QColor(RegionGrid::colorFor(m_field, value)));
+        painter.drawLine(legend.left() + x, legend.top(), legend.left() + x, legend.bottom());
+    }
+
+    QString unit = m_field == RegionGrid::Precipitation ? TR("Heatmap/unit_mm")
+                                                        : (m_isCelsius ? "°C" : "°F");
+    auto label = [this](float value) {
+        if (m_field == RegionGrid::Temperature && !m_isCelsius) value = value * 9.0f / 5.0f + 32.0f;
+        return QString::number(value, 'f', 0);
+    };
+    painter.setPen(palette().color(QPalette::Text));
+    painter.drawText(QRect(map.left(), legend.top() - 2, 38, legend.height() + 4),
+                     Qt::AlignRight | Qt::AlignVCenter, label(low));
+    painter.drawText(QRect(legend.right() + 4, legend.top() - 2, 38, legend.height() + 4),
+                     Qt::AlignLeft | Qt::AlignVCenter, label(high) + unit);
+}
+
+void HeatmapView::mousePressEvent(QMouseEvent *event)
+{
+    m_dragOrigin = event->pos();
+}
+
+void HeatmapView::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!(event->buttons() & Qt::LeftButton)) return;
+
+    // Сдвиг целыми узлами: перетаскивание карты вправо открывает запад
+    double cellWidth = double(width()) / GRID_COLS;
+    double cellHeight = double(height() - LEGEND_HEIGHT) / GRID_ROWS;
+    int cols = int((m_dragOrigin.x() - event->pos().x()) / cellWidth);
+    int rows = int((event->pos().y() - m_dragOrigin.y()) / cellHeight);
+    if (rows == 0 && cols == 0) return;
+
+    m_dragOrigin += QPoint(int(-cols * cellWidth), int(rows * cellHeight));
+    emit panned(rows, cols);
+}
+
+HeatmapDialog::HeatmapDialog(RegionGrid *grid, const QString &location, const GeoPoint &point,
+                             bool celsius, QWidget *parent)
+    : QDialog(parent)
+    , m_grid(grid)
+    , m_point(point)
+    , m_center(point)
+    , m_zoom(1)
+    , m_isCelsius(celsius)
+    , m_generation(0)
+    , m_images(IMAGE_CACHE_KB)
+    , m_fieldCombo(new QComboBox(this))
+    , m_zoomOutButton(new QPushButton("-", this))
+    , m_zoomInButton(new QPushButton("+", this))
+    , m_view(new HeatmapView(this))
+    , m_statusLabel(new QLabel(this))
+    , m_refreshTimer(new QTimer(this))
+{
+    setWindowTitle(TR("Heatmap/title") + ": " + location);
+
+    m_fieldCombo->addItem(TR("Heatmap/field_temp"), RegionGrid::Temperature);
+    m_fieldCombo->addItem(TR("Heatmap/field_precip"), RegionGrid::Precipitation);
+    m_zoomOutButton->setToolTip(TR("Heatmap/zoom_out"));
+    m_zoomInButton->setToolTip(TR("Heatmap/zoom_in"));
+    m_zoomOutButton->setFixedWidth(32);
+    m_zoomInButton->setFixedWidth(32);
+
+    QHBoxLayout *controls = new QHBoxLayout();
+    controls->addWidget(m_fieldCombo);
+    controls->addWidget(m_zoomOutButton);
+    controls->addWidget(m_zoomInButton);
+    controls->addStretch();
+    controls->addWidget(m_statusLabel);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(controls);
+    layout->addWidget(m_view, 1);
+
+    // Пачки узлов приходят одна за другой - перерисовка одна на серию
+    m_refreshTimer->setSingleShot(true);
+    m_refreshTimer->setInterval(100);
+    connect(m_refreshTimer, &QTimer::timeout, this, &HeatmapDialog::refresh);
+    connect(m_grid, &RegionGrid::cellsArrived, this, [this](int zoom) {
+        if (zoom == m_zoom) m_refreshTimer->start();
+    });
+
+    connect(m_fieldCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &HeatmapDialog::refresh);
+    connect(m_zoomOutButton, &QPushButton::clicked, this, [this]() { zoomBy(-1); });
+    connect(m_zoomInButton, &QPushButton::clicked, this, [this]() { zoomBy(1); });
+    connect(m_view, &HeatmapView::panned, this, &HeatmapDialog::pan);
+
+    refresh();
+}
+
+void HeatmapDialog::keyPressEvent(QKeyEvent *event)
+{
+    switch (event->key()) {
+    case Qt::Key_Left: pan(0, -1); break;
+    case Qt::Key_Right: pan(0, 1); break;
+    case Qt::Key_Up: pan(1, 0); break;
+    case Qt::Key_Down: pan(-1, 0); break;
+    case Qt::Key_Plus: zoomBy(1); break;
+    case Qt::Key_Minus: zoomBy(-1); break;
+    default: QDialog::keyPressEvent(event); return;
+    }
+}
+
+void HeatmapDialog::pan(int rows, int cols)
+{
+    double step = RegionGrid::stepForZoom(m_zoom);
+    m_center.lat = qBound(-85.0, m_center.lat + rows * step, 85.0);
+    m_center.lon += cols * step;
+    refresh();
+}
+
+void HeatmapDialog::zoomBy(int delta)
+{
+    int zoom = qBound(0, m_zoom + delta, RegionGrid::zoomLevels() - 1);
+    if (zoom == m_zoom) return;
+    m_zoom = zoom;
+    refresh();
+}
+
+QString HeatmapDialog::cacheKey(const GridWindow &window) const
+{
+    return QString("%1/%2/%3/%4/%5").arg(window.zoom).arg(window.row0).arg(window.col0)
+            .arg(m_fieldCombo->currentData().toInt()).arg(window.revision);
+}
+
+void HeatmapDialog::refresh()
+{
+    m_zoomOutButton->setEnabled(m_zoom > 0);
+    m_zoomInButton->setEnabled(m_zoom < RegionGrid::zoomLevels() - 1);
+
+    int row0 = RegionGrid::rowFor(m_center.lat, m_zoom) - GRID_ROWS / 2;
+    int col0 = RegionGrid::colFor(m_center.lon, m_zoom) - GRID_COLS / 2;
+    GridWindow window = m_grid->window(m_zoom, row0, col0, GRID_ROWS, GRID_COLS);
+    RegionGrid::Field field = static_cast<RegionGrid::Field>(m_fieldCombo->currentData().toInt());
+
+    // Город относительно окна: доли ширины слева и высоты сверху
+    double step = RegionGrid::stepForZoom(m_zoom);
+    double lonOffset = std::fmod(m_point.lon - col0 * step + 540.0, 360.0) - 180.0;
+    m_view->setMarker(QPointF(lonOffset / (GRID_COLS * step),
+                              1.0 - (m_point.lat - row0 * step) / (GRID_ROWS * step)));
+    m_view->setLegend(field, m_isCelsius);
+
+    QString pending = m_grid->pendingCells() > 0
+            ? TR("Heatmap/loading").arg(m_grid->pendingCells()) : QString();
+
+    QString key = cacheKey(window);
+    if (QImage *cached = m_images.object(key)) {
+        m_view->setImage(*cached);
+        m_statusLabel->setText(pending);
+        return;
+    }
+
+    // Растр считается в пуле потоков; устаревшие результаты отбрасываются
+    quint64 generation = ++m_generation;
+    QSize size(GRID_COLS * CELL_PIXELS, GRID_ROWS * CELL_PIXELS);
+    QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this);
+    QElapsedTimer timer;
+    timer.start();
+
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, timer, generation, key, pending]() {
+        watcher->deleteLater();
+        qint64 ms = timer.elapsed();
+
+        QImage image = watcher->result();
+        m_images.insert(key, new QImage(image), qMax(1, image.bytesPerLine() * image.height() / 1024));
+        if (generation != m_generation) return;
+
+        m_view->setImage(image);
+        m_statusLabel->setText((pending.isEmpty() ? QString() : pending + "  ")
+                               + TR("Heatmap/render").arg(ms));
+    });
+    watcher->setFuture(QtConcurrent::run([window, field, size]() {
+        return RegionGrid::rasterize(window, field, size);
+    }));
+}
@@ -0,0 +1,81 @@
+#ifndef HEATMAPDIALOG_H
+#define HEATMAPDIALOG_H
+
+#include <QDialog>
+#include <QWidget>
+#include <QCache>
+#include <QImage>
+#include "regiongrid.h"
+
+class QComboBox;
+class QLabel;
+class QPushButton;
+class QTimer;
+
+// Карта: растр окна решётки, отметка города и шкала; перетаскивание сдвигает окно
+class HeatmapView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit HeatmapView(QWidget *parent = nullptr);
+
+    void setImage(const QImage &image);
+    // Положение города в долях ширины и высоты окна
+    void setMarker(const QPointF &marker) { m_marker = marker; update(); }
+    void setLegend(RegionGrid::Field field, bool celsius);
+
+signals:
+    void panned(int rows, int cols);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private:
+    QImage m_image;
+    QPointF m_marker;
+    RegionGrid::Field m_field;
+    bool m_isCelsius;
+    QPoint m_dragOrigin;
+};
+
+class HeatmapDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    HeatmapDialog(RegionGrid *grid, const QString &location, const GeoPoint &point,
+                  bool celsius, QWidget *parent = nullptr);
+
+protected:
+    void keyPressEvent(QKeyEvent *event) override;
+
+private slots:
+    void refresh();
+    void pan(int rows, int cols);
+    void zoomBy(int delta);
+
+private:
+    QString cacheKey(const GridWindow &window) const;
+
+    RegionGrid *m_grid;
+    GeoPoint m_point;
+    GeoPoint m_center;
+    int m_zoom;
+    bool m_isCelsius;
+    quint64 m_generation;
+
+    // Готовые растры по масштабам: возврат к прежнему виду не пересчитывается
+    QCache<QString, QImage> m_images;
+
+    QComboBox *m_fieldCombo;
+    QPushButton *m_zoomOutButton;
+    QPushButton *m_zoomInButton;
+    HeatmapView *m_view;
+    QLabel *m_statusLabel;
+    QTimer *m_refreshTimer;
+};
+
+#endif // HEATMAPDIALOG_H
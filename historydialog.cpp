@@ -0,0 +1,173 @@
+#include "historydialog.h"
+#include "translator.h"
+#include <QComboBox>
+#include <QLabel>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPainter>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QDebug>
+
+namespace {
+const qint64 HOUR = 3600;
+const qint64 DAY = 24 * HOUR;
+const int CHART_MARGIN = 32;
+}
+
+HistoryChart::HistoryChart(QWidget *parent)
+    : QWidget(parent)
+{
+    setMinimumSize(480, 240);
+}
+
+void HistoryChart::setBuckets(const QVector<HistoryBucket> &buckets, const QString &unit)
+{
+    m_buckets = buckets;
+    m_unit = unit;
+    update();
+}
+
+void HistoryChart::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    emit widthChanged(width());
+}
+
+void HistoryChart::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().color(QPalette::AlternateBase));
+
+    float minValue = 0;
+    float maxValue = 0;
+    bool hasData = false;
+    for (const HistoryBucket &bucket : m_buckets) {
+        if (!bucket.valid) continue;
+        if (!hasData) {
+            minValue = bucket.min;
+            maxValue = bucket.max;
+            hasData = true;
+        } else {
+            minValue = qMin(minValue, bucket.min);
+            maxValue = qMax(maxValue, bucket.max);
+        }
+    }
+
+    painter.setPen(palette().color(QPalette::Text));
+    if (!hasData) {
+        painter.drawText(rect(), Qt::AlignCenter, TR("History/no_data"));
+        return;
+    }
+
+    QRect plot = rect().adjusted(CHART_MARGIN, 8, -8, -8);
+    float span = qMax(maxValue - minValue, 1.0f);
+
+    painter.drawText(QRect(0, plot.top(), CHART_MARGIN - 4, 20), Qt::AlignRight | Qt::AlignTop,
+                     QString::number(maxValue, 'f', 0));
+    painter.drawText(QRect(0, plot.bottom() - 20, CHART_MARGIN - 4, 20), Qt::AlignRight | Qt::AlignBottom,
+                     QString::number(minValue, 'f', 0));
+    painter.drawText(QRect(0, plot.center().y() - 10, CHART_MARGIN - 4, 20), Qt::AlignRight | Qt::AlignVCenter,
+                     m_unit);
+
+    // Столбик на каждый интервал: от минимума до максимума за интервал
+    painter.setPen(palette().color(QPalette::Highlight).lighter(130));
+    int count = m_buckets.size();
+    for (int i = 0; i < count; ++i) {
+        const HistoryBucket &bucket = m_buckets[i];
+        if (!bucket.valid) continue;
+
+        int x = plot.left() + i * plot.width() / count;
+        int yMax = plot.bottom() - int((bucket.max - minValue) / span * plot.height());
+        int yMin = plot.bottom() - int((bucket.min - minValue) / span * plot.height());
+        painter.drawLine(x, yMin, x, qMin(yMax, yMin - 1));
+    }
+}
+
+HistoryDialog::HistoryDialog(ObservationHistory *history, const QString &location,
+                             bool celsius, QWidget *parent)
+    : QDialog(parent)
+    , m_history(history)
+    , m_location(location)
+    , m_isCelsius(celsius)
+    , m_rangeCombo(new QComboBox(this))
+    , m_fieldCombo(new QComboBox(this))
+    , m_chart(new HistoryChart(this))
+    , m_statusLabel(new QLabel(this))
+{
+    setWindowTitle(TR("History/title") + ": " + location);
+    resize(720, 360);
+
+    m_rangeCombo->addItem(TR("History/range_day"), DAY);
+    m_rangeCombo->addItem(TR("History/range_week"), 7 * DAY);
+    m_rangeCombo->addItem(TR("History/range_month"), 30 * DAY);
+    m_rangeCombo->addItem(TR("History/range_year"), 365 * DAY);
+
+    m_fieldCombo->addItem(TR("History/field_temp"), ObservationHistory::Temperature);
+    m_fieldCombo->addItem(TR("History/field_feels"), ObservationHistory::FeelsLike);
+    m_fieldCombo->addItem(TR("History/field_humidity"), ObservationHistory::Humidity);
+    m_fieldCombo->addItem(TR("History/field_wind"), ObservationHistory::WindSpeed);
+
+    QHBoxLayout *controls = new QHBoxLayout();
+    controls->addWidget(m_rangeCombo);
+    controls->addWidget(m_fieldCombo);
+    controls->addStretch();
+    controls->addWidget(m_statusLabel);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(controls);
+    layout->addWidget(m_chart, 1);
+
+    connect(m_rangeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &HistoryDialog::reload);
+    connect(m_fieldCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &HistoryDialog::reload);
+    connect(m_chart, &HistoryChart::widthChanged, this, &HistoryDialog::reload);
+}
+
+void HistoryDialog::reload()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    qint64 to = QDateTime::currentSecsSinceEpoch();
+    qint64 from = to - m_rangeCombo->currentData().toLongLong();
+    ObservationHistory::Field field =
+            static_cast<ObservationHistory::Field>(m_fieldCombo->currentData().toInt());
+
+    int buckets = qMax(1, m_chart->width() - CHART_MARGIN - 8);
+    QVector<HistoryBucket> data = m_history->downsample(m_location, field, from, to, buckets);
+    int samples = m_history->count(m_location, from, to);
+
+    // Единицы измерения как в главном окне
+    QString unit;
+    switch (field) {
+    case ObservationHistory::Humidity:
+        unit = "%";
+        break;
+    case ObservationHistory::WindSpeed:
+        unit = m_isCelsius ? TR("Weather/speed_ms") : TR("Weather/speed_mph");
+        if (!m_isCelsius) {
+            for (HistoryBucket &bucket : data) {
+                bucket.min *= 2.237f;
+                bucket.max *= 2.237f;
+            }
+        }
+        break;
+    default:
+        unit = m_isCelsius ? "°C" : "°F";
+        if (!m_isCelsius) {
+            for (HistoryBucket &bucket : data) {
+                bucket.min = bucket.min * 9.0f / 5.0f + 32.0f;
+                bucket.max = bucket.max * 9.0f / 5.0f + 32.0f;
+            }
+        }
+        break;
+    }
+
+    m_chart->setBuckets(data, unit);
+    m_statusLabel->setText(TR("History/samples") + QString::number(samples));
+
+    qDebug() << "History query:" << m_location << "samples:" << samples
+             << "buckets:" << buckets << "ms:" << timer.nsecsElapsed() / 1000000.0;
+}
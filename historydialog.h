@@ -0,0 +1,55 @@
+#ifndef HISTORYDIALOG_H
+#define HISTORYDIALOG_H
+
+#include <QDialog>
+#include <QWidget>
+#include "observationhistory.h"
+
+class QComboBox;
+class QLabel;
+
+// График истории: по одному столбику min..max на пиксель ширины
+class HistoryChart : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit HistoryChart(QWidget *parent = nullptr);
+
+    void setBuckets(const QVector<HistoryBucket> &buckets, const QString &unit);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+signals:
+    void widthChanged(int width);
+
+private:
+    QVector<HistoryBucket> m_buckets;
+    QString m_unit;
+};
+
+class HistoryDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    HistoryDialog(ObservationHistory *history, const QString &location,
+                  bool celsius, QWidget *parent = nullptr);
+
+private slots:
+    void reload();
+
+private:
+    ObservationHistory *m_history;
+    QString m_location;
+    bool m_isCelsius;
+
+    QComboBox *m_rangeCombo;
+    QComboBox *m_fieldCombo;
+    HistoryChart *m_chart;
+    QLabel *m_statusLabel;
+};
+
+#endif // HISTORYDIALOG_H
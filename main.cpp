@@ -1,54 +1,195 @@
 #include "mainwindow.h"
+#include "singleinstance.h"
+#include "memorybench.h"
+#include "serverbench.h"
+#include "startupprofile.h"
+#include "stylebench.h"
+#include "networkcapture.h"
 #include <QApplication>
 #include <QDebug>
-#include <QDir>
+#include <QFileInfo>
 #include <QMessageBox>
+#include <QCommandLineParser>
+
+namespace {
+// Параметры Qt, которые позже разберёт и удалит из argv сам QApplication.
+// Пробный разбор их только пропускает, иначе "-platform offscreen" - неизвестная опция
+void addGuiOptions(QCommandLineParser *parser)
+{
+    const char *valueOptions[] = {
+        "platform", "platformpluginpath", "platformtheme", "plugin", "qwindowgeometry",
+        "qwindowicon", "qwindowtitle", "session", "style", "stylesheet", "display",
+        "geometry", "title", "name", "qmljsdebugger"
+    };
+    const char *flagOptions[] = {
+        "reverse", "widgetcount", "nograb", "dograb", "sync"
+    };
+
+    for (const char *name : valueOptions) {
+        QCommandLineOption option(QString::fromLatin1(name), QString(), "value");
+        option.setFlags(QCommandLineOption::HiddenFromHelp);
+        parser->addOption(option);
+    }
+    for (const char *name : flagOptions) {
+        QCommandLineOption option(QString::fromLatin1(name));
+        option.setFlags(QCommandLineOption::HiddenFromHelp);
+        parser->addOption(option);
+    }
+}
+}
 
 int main(int argc, char *argv[])
 {
+    StartupProfile::start();
+
+    QString location;
+    bool coordinates = false;
+    bool newInstance = false;
+    int servePort = 0;
+    int benchStyleRows = 0;
+
+    // Аргументы разбираются до QApplication: повторному запуску не нужны ни окно,
+    // ни платформенный плагин - только передать запрос работающему экземпляру
+    {
+        QCoreApplication probe(argc, argv);
+        probe.setApplicationName("SimpleWeather");
+        probe.setOrganizationName("WeatherApp");
+
+        QCommandLineParser parser;
+        // Параметры Qt пишутся с одним дефисом: -platform, -style, -reverse
+        parser.setSingleDashWordOptionMode(QCommandLineParser::ParseAsLongOptions);
+        parser.addHelpOption();
+        addGuiOptions(&parser);
+        QCommandLineOption coordsOption("coords", "Show weather for coordinates", "lat,lon");
+        parser.addOption(coordsOption);
+        QCommandLineOption newInstanceOption("new-instance", "Do not hand the request to a running instance");
+        parser.addOption(newInstanceOption);
+        QCommandLineOption serveOption("serve", "Serve cached weather as JSON over HTTP on the given port", "port");
+        parser.addOption(serveOption);
+        QCommandLineOption benchMemoryOption("bench-memory", "Print memory use of weather records for 1k/10k locations and exit");
+        parser.addOption(benchMemoryOption);
+        QCommandLineOption startupProfileOption("startup-profile", "Print startup phase timings after the first paint");
+        parser.addOption(startupProfileOption);
+        QCommandLineOption startupExitOption("startup-exit", "Exit right after the first paint");
+        parser.addOption(startupExitOption);
+        QCommandLineOption benchStartupOption("bench-startup", "Measure cold start over several runs and exit", "runs");
+        parser.addOption(benchStartupOption);
+        QCommandLineOption benchServerOption("bench-server", "Load-test the HTTP server with concurrent clients and exit", "clients");
+        parser.addOption(benchServerOption);
+        QCommandLineOption benchStyleOption("bench-style", "Measure polish and layout of forecast rows and exit", "rows");
+        parser.addOption(benchStyleOption);
+        QCommandLineOption captureOption("capture", "Record all network exchanges to a capture file", "file");
+        parser.addOption(captureOption);
+        QCommandLineOption replayOption("replay", "Serve network requests from a capture file instead of the network", "file");
+        parser.addOption(replayOption);
+        QCommandLineOption replaySpeedOption("replay-speed", "Replay timing factor: 1 - as recorded, 2 - twice as fast, 0 - no delays", "factor", "1");
+        parser.addOption(replaySpeedOption);
+        parser.addPositionalArgument("city", "City to show", "[city]");
+        parser.process(probe);
+
+        if (parser.isSet(benchMemoryOption)) {
+            return runMemoryBenchmark();
+        }
+        if (parser.isSet(benchStartupOption)) {
+            return runStartupBenchmark(parser.value(benchStartupOption).toInt());
+        }
+        if (parser.isSet(benchServerOption)) {
+            return runServerBenchmark(parser.value(benchServerOption).toInt());
+        }
+        if (parser.isSet(benchStyleOption)) {
+            // Полировке нужны виджеты, поэтому замер идёт после создания QApplication
+            benchStyleRows = qMax(1, parser.value(benchStyleOption).toInt());
+        }
+        StartupProfile::configure(parser.isSet(startupProfileOption), parser.isSet(startupExitOption));
+
+        if (parser.isSet(replayOption)) {
+            NetworkCapture::configure(NetworkCapture::Replay, parser.value(replayOption),
+                                      parser.value(replaySpeedOption).toDouble());
+        } else if (parser.isSet(captureOption)) {
+            NetworkCapture::configure(NetworkCapture::Capture, parser.value(captureOption));
+        }
+
+        if (parser.isSet(coordsOption)) {
+            location = parser.value(coordsOption);
+            coordinates = true;
+        } else if (!parser.positionalArguments().isEmpty()) {
+            location = parser.positionalArguments().join(' ');
+        }
+        newInstance = parser.isSet(newInstanceOption);
+        if (parser.isSet(serveOption)) {
+            servePort = parser.value(serveOption).toInt();
+            if (servePort <= 0 || servePort > 65535) {
+                qWarning() << "Invalid port:" << parser.value(serveOption);
+                servePort = 0;
+            }
+        }
+
+        // Сервер, запись и воспроизведение сети настраивают именно этот процесс:
+        // передать их работающему экземпляру нельзя, поэтому запускается новый
+        // и сокет работающего экземпляра не перехватывает
+        bool ownProcess = benchStyleRows > 0 || parser.isSet(serveOption)
+                || parser.isSet(captureOption) || parser.isSet(replayOption)
+                || parser.isSet(startupProfileOption);
+        if (ownProcess) {
+            newInstance = true;
+        }
+        if (!newInstance && SingleInstance::forwardToRunning(location)) {
+            return 0;
+        }
+    }
+    StartupProfile::mark("arguments");
+
     QApplication a(argc, argv);
+    StartupProfile::mark("qapplication");
 
     a.setApplicationName("SimpleWeather");
     a.setOrganizationName("WeatherApp");
 
-    // Проверяем наличие папки lang ДО запуска главного окна
+    if (benchStyleRows > 0) {
+        return runStyleBenchmark(benchStyleRows);
+    }
+
+    // Проверяем наличие папки lang ДО запуска главного окна. Сами файлы языков
+    // не перечисляем: текущий загрузит Translator, второй - только при переключении
     QString appDir = a.applicationDirPath();
     QString langDir = appDir + "/lang";
 
-    qDebug() << "===========================================";
-    qDebug() << "Application starting...";
-    qDebug() << "Executable directory:" << appDir;
-    qDebug() << "Language folder path:" << langDir;
-    qDebug() << "Language folder exists?" << QDir(langDir).exists();
-
-    if (!QDir(langDir).exists()) {
+    if (!QFileInfo(langDir).isDir()) {
         qCritical() << "CRITICAL ERROR: 'lang' folder not found!";
-        qCritical() << "Please create folder 'lang' next to the executable";
         qCritical() << "Expected location:" << langDir;
 
         QMessageBox::critical(nullptr, "Error",
             QString("Language files not found!\n\n"
                    "Please create 'lang' folder with ru.ini and en.ini\n"
                    "in the same directory as the executable:\n\n%1").arg(appDir));
-    } else {
-        qDebug() << "Language folder found!";
-
-        // Проверяем наличие файлов
-        QDir dir(langDir);
-        QStringList langFiles = dir.entryList(QStringList() << "*.ini", QDir::Files);
-        qDebug() << "Language files found:" << langFiles;
-
-        if (!langFiles.contains("ru.ini")) {
-            qWarning() << "WARNING: ru.ini not found in lang folder!";
-        }
-        if (!langFiles.contains("en.ini")) {
-            qWarning() << "WARNING: en.ini not found in lang folder!";
-        }
     }
-    qDebug() << "===========================================";
+    StartupProfile::mark("lang_check");
 
     MainWindow w;
+    StartupProfile::mark("main_window");
+    StartupProfile::watchFirstPaint(&w);
     w.show();
+    StartupProfile::mark("show");
+
+    SingleInstance instance;
+    if (!newInstance && instance.listen()) {
+        QObject::connect(&instance, &SingleInstance::activationRequested, &w, &MainWindow::activate);
+    }
+
+    if (servePort > 0) {
+        w.startServer(quint16(servePort));
+    }
+
+    if (coordinates) {
+        GeoPoint point;
+        if (CityIndex::parseCoordinates(location, &point)) {
+            w.loadCoordinates(point);
+        } else {
+            qWarning() << "Invalid coordinates:" << location;
+        }
+    } else if (!location.isEmpty()) {
+        w.activate(location);
+    }
 
     return a.exec();
 }
@@ -1,25 +1,80 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "translator.h"
+#include "weathericons.h"
+#include "historydialog.h"
+#include "climatedialog.h"
+#include "heatmapdialog.h"
+#include "alertsdialog.h"
+#include "ensemblechart.h"
+#include "forecastdayrow.h"
+#include "nowcastchart.h"
+#include "startupprofile.h"
 #include <QMessageBox>
 #include <QUrlQuery>
 #include <QPixmap>
 #include <QDateTime>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QWindow>
+#include <QScreen>
+#include <QStandardPaths>
+#include <QMenuBar>
+#include <QSignalBlocker>
+#include <QSystemTrayIcon>
+#include <QStatusBar>
+#include <QScrollBar>
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+// Ближе этого точка считается самим городом, дальше - "рядом с городом",
+// а за вторым порогом город уже ничего не говорит о месте
+const double CITY_RADIUS_KM = 25.0;
+const double NEAR_CITY_RADIUS_KM = 150.0;
+}
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
-    , m_networkManager(new QNetworkAccessManager(this))
+    , m_service(nullptr)
     , m_settings(new QSettings(this))
-    , m_refreshTimer(new QTimer(this))
     , m_searchDebounceTimer(new QTimer(this))
+    , m_nowcastTimer(new QTimer(this))
+    , m_trayIcon(nullptr)
+    , m_favoritesModel(new FavoritesModel(this))
+    , m_favoritesDelegate(new FavoritesDelegate(this))
+    , m_favoritesStore(new FavoritesStore(this))
+    , m_prefetcher(nullptr)
+    , m_detailLoader(nullptr)
+    , m_regionGrid(nullptr)
+    , m_nowcast(nullptr)
+    , m_nowcastChart(nullptr)
+    , m_server(nullptr)
+    , m_alertEngine(new AlertEngine(this))
     , m_currentLanguage("ru")
     , m_isCelsius(true)
-    , m_completerModel(new QStringListModel(this))
-    , m_hasWeatherData(false)
+    , m_theme(ThemeEngine::Dark)
+    , m_screenTracked(false)
+    , m_completer(nullptr)
+    , m_completerModel(nullptr)
+    , m_suggestionTicket(0)
+    , m_currentPosition()
+    , m_hasPosition(false)
+    , m_startupLoadPending(false)
+    , m_citySubscription(0)
+    , m_ensembleFetchedAt(0)
+    , m_ensembleMode(false)
+    , m_nowcastMode(false)
+    , m_expandedLocation(LocationTable::InvalidId)
 {
     ui->setupUi(this);
+    StartupProfile::mark("setup_ui");
+
+    ui->m_favoritesList->setModel(m_favoritesModel);
+    ui->m_favoritesList->setItemDelegate(m_favoritesDelegate);
+    ui->m_favoritesList->setMouseTracking(true);
+    ui->m_extraLabel->hide();
 
     qDebug() << "=== MainWindow initialization ===";
 
@@ -35,19 +90,38 @@ MainWindow::MainWindow(QWidget *parent)
             qCritical() << "Make sure 'lang' folder exists next to the executable!";
         }
     }
+    StartupProfile::mark("language");
+
+    // Сеть, кэши и расписание обновления - в общем сервисе; сама сеть создаётся при первом запросе
+    m_service = new WeatherService(WEATHER_API_URL, GEOCODING_API_URL, this);
+    m_service->setLanguage(m_currentLanguage);
+    connect(m_service, &WeatherService::resultReady, this, &MainWindow::onWeatherResult);
+    connect(m_service, &WeatherService::positionResolved, this, [this](const QString &city, const GeoPoint &point) {
+        if (m_favoritesModel->contains(city)) {
+            m_favoritesStore->saveCoordinates(city, point.lat, point.lon);
+        }
+    });
 
     // Теперь загружаем остальные настройки
     loadSettings();
+    StartupProfile::mark("settings");
+
+    // Индекс городов для ввода координат и обратного поиска ближайшего города
+    m_cityIndex.load(":/res/cities.csv");
+
+    // Журнал наблюдений рядом с хранилищем избранного
+    m_history.open(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    StartupProfile::mark("city_index_history");
+
+    // Упреждающая загрузка, почасовая детализация и автодополнение
+    // создаются при первом обращении: до первого кадра они не нужны
 
     // Применяем тему и обновляем язык UI
     applyTheme();
+    setupMenus();
     updateLanguage();
     setupConnections();
-
-    // Настройка автодополнения
-    m_completer = new QCompleter(m_completerModel, this);
-    m_completer->setCaseSensitivity(Qt::CaseInsensitive);
-    ui->m_searchInput->setCompleter(m_completer);
+    StartupProfile::mark("theme_menus_connections");
 
     // Настройка таймера для задержки автодополнения
     m_searchDebounceTimer->setSingleShot(true);
@@ -59,47 +133,113 @@ MainWindow::MainWindow(QWidget *parent)
         }
     });
 
-    // Игнорируем SSL ошибки
-    connect(m_networkManager, &QNetworkAccessManager::sslErrors,
-            this, &MainWindow::onSslErrors);
-
-    connect(m_networkManager, &QNetworkAccessManager::finished,
-            this, [this](QNetworkReply *reply) {
-        QString url = reply->url().toString();
-        if (url.contains("geocoding-api")) {
-            if (m_searchReplies.contains(reply)) {
-                m_searchReplies.remove(reply);
-                onSearchFinished(reply);
-            } else if (url.contains("count=10")) {
-                onSuggestionsFinished(reply);
-            }
-        } else if (url.contains("forecast") && url.contains("current")) {
-            onWeatherFinished(reply);
-        } else if (url.contains("forecast") && url.contains("daily")) {
-            onForecastFinished(reply);
-        }
-    });
+    // Текущий город и избранное обновляет сервис по своему расписанию
 
-    m_refreshTimer->setInterval(600000); // 10 минут
-    connect(m_refreshTimer, &QTimer::timeout, this, &MainWindow::refreshCurrentCity);
-    m_refreshTimer->start();
+    // 15-минутный прогноз обновляется чаще остального, но только новым окном
+    m_nowcastTimer->setInterval(300000); // 5 минут
+    connect(m_nowcastTimer, &QTimer::timeout, this, &MainWindow::refreshNowcast);
+    if (m_nowcastMode) {
+        toggleNowcast(true);
+    }
 
     // Автозагрузка последнего города
     if (!m_currentCity.isEmpty()) {
         qDebug() << "Loading last city:" << m_currentCity;
+        m_startupLoadPending = true;
         QTimer::singleShot(100, this, [this]() {
-            fetchWeather(m_currentCity);
-            fetchForecast(m_currentCity);
+            // Координаты из командной строки уже могли заменить последний город
+            if (m_startupLoadPending) {
+                m_startupLoadPending = false;
+                refreshCurrentCity();
+            }
         });
     }
 }
 
 MainWindow::~MainWindow()
 {
-    saveSettings();
+    saveLastLocation();
+    // Упреждающая загрузка отменяет свои запросы в деструкторе - пока планировщик жив
+    delete m_prefetcher;
     delete ui;
 }
 
+SuggestionPrefetcher *MainWindow::prefetcher()
+{
+    if (!m_prefetcher) {
+        m_prefetcher = new SuggestionPrefetcher(m_service->scheduler(), WEATHER_API_URL, this);
+        connect(m_prefetcher, &SuggestionPrefetcher::awaitedReady, this, &MainWindow::onPrefetchReady);
+    }
+    return m_prefetcher;
+}
+
+ForecastDetailLoader *MainWindow::detailLoader()
+{
+    if (!m_detailLoader) {
+        m_detailLoader = new ForecastDetailLoader(m_service->scheduler(), WEATHER_API_URL, this);
+        connect(m_detailLoader, &ForecastDetailLoader::loaded, this, &MainWindow::onForecastDetailLoaded);
+    }
+    return m_detailLoader;
+}
+
+NowcastFeed *MainWindow::nowcast()
+{
+    if (!m_nowcast) {
+        m_nowcast = new NowcastFeed(m_service->scheduler(), WEATHER_API_URL, this);
+        if (m_nowcastChart) {
+            m_nowcastChart->setBuffer(&m_nowcast->buffer());
+        }
+        connect(m_nowcast, &NowcastFeed::updated, this, [this](qint64 from, qint64 to) {
+            if (m_nowcastChart) {
+                m_nowcastChart->updateRange(from, to, m_nowcast->localNow());
+            }
+        });
+    }
+    return m_nowcast;
+}
+
+void MainWindow::ensureCompleter()
+{
+    if (m_completer) return;
+
+    // Настройка автодополнения
+    m_completerModel = new QStringListModel(this);
+    m_completer = new QCompleter(m_completerModel, this);
+    m_completer->setCaseSensitivity(Qt::CaseInsensitive);
+    ui->m_searchInput->setCompleter(m_completer);
+}
+
+void MainWindow::showEvent(QShowEvent *event)
+{
+    QMainWindow::showEvent(event);
+
+    // При переносе окна на экран с другим масштабом иконки берутся из атласа под новый DPR
+    if (!m_screenTracked && windowHandle()) {
+        m_screenTracked = true;
+        connect(windowHandle(), &QWindow::screenChanged, this, [this](QScreen *) {
+            redisplayWeather();
+        });
+    }
+}
+
+void MainWindow::setupMenus()
+{
+    m_viewMenu = ui->menuBar->addMenu(QString());
+    m_historyAction = m_viewMenu->addAction(QString(), this, &MainWindow::showHistory);
+    m_climateAction = m_viewMenu->addAction(QString(), this, &MainWindow::showClimate);
+    m_heatmapAction = m_viewMenu->addAction(QString(), this, &MainWindow::showHeatmap);
+    m_alertsAction = m_viewMenu->addAction(QString(), this, &MainWindow::showAlerts);
+    m_viewMenu->addSeparator();
+    m_ensembleAction = m_viewMenu->addAction(QString());
+    m_ensembleAction->setCheckable(true);
+    m_ensembleAction->setChecked(m_ensembleMode);
+    connect(m_ensembleAction, &QAction::toggled, this, &MainWindow::toggleEnsemble);
+    m_nowcastAction = m_viewMenu->addAction(QString());
+    m_nowcastAction->setCheckable(true);
+    m_nowcastAction->setChecked(m_nowcastMode);
+    connect(m_nowcastAction, &QAction::toggled, this, &MainWindow::toggleNowcast);
+}
+
 void MainWindow::setupConnections()
 {
     connect(ui->m_searchButton, &QPushButton::clicked, this, &MainWindow::searchCity);
@@ -107,14 +247,18 @@ void MainWindow::setupConnections()
     connect(ui->m_favoriteButton, &QPushButton::clicked, this, &MainWindow::addToFavorites);
     connect(ui->m_languageButton, &QPushButton::clicked, this, &MainWindow::toggleLanguage);
     connect(ui->m_refreshButton, &QPushButton::clicked, this, &MainWindow::refreshCurrentCity);
+    connect(ui->m_themeButton, &QPushButton::clicked, this, &MainWindow::toggleTheme);
     connect(ui->m_unitsCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &MainWindow::toggleUnits);
-    connect(ui->m_favoritesList, &QListWidget::itemDoubleClicked,
-            this, [this](QListWidgetItem *item) {
-        loadFavoriteCity(item->text());
+    connect(ui->m_favoritesList, &QListView::doubleClicked,
+            this, [this](const QModelIndex &index) {
+        loadFavoriteCity(index.data(FavoritesModel::CityRole).toString());
     });
     connect(ui->removeFavButton, &QPushButton::clicked, this, &MainWindow::removeFromFavorites);
     connect(ui->m_searchInput, &QLineEdit::textChanged, this, &MainWindow::updateSearchSuggestions);
+    connect(m_alertEngine, &AlertEngine::triggered, this, &MainWindow::onAlertTriggered);
+    connect(ui->m_scrollArea->verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &MainWindow::updateDetailLoads);
 }
 
 void MainWindow::searchCity()
@@ -125,6 +269,38 @@ void MainWindow::searchCity()
         return;
     }
 
+    // Координаты ищем сразу в локальном индексе, без геокодера
+    GeoPoint point;
+    if (CityIndex::parseCoordinates(city, &point)) {
+        loadCoordinates(point);
+        return;
+    }
+
+    // Подсказку могли загрузить заранее - тогда погода показывается сразу
+    QJsonObject prefetched;
+    switch (prefetcher()->lookup(city, &prefetched, &point)) {
+    case SuggestionPrefetcher::Ready:
+        // Упреждающий ответ - только прогноз, воздух и море сервис догрузит сам
+        m_service->setPosition(city, point);
+        m_service->ingest(city, prefetched);
+        showCity(city);
+        return;
+    case SuggestionPrefetcher::Pending:
+        // Ответ уже в пути: дожидаемся его вместо нового запроса
+        if (m_citySubscription) {
+            m_service->unsubscribe(m_citySubscription);
+            m_citySubscription = 0;
+        }
+        m_currentCity = city;
+        m_currentPosition = point;
+        m_hasPosition = true;
+        m_startupLoadPending = false;
+        m_service->setPosition(city, point);
+        return;
+    case SuggestionPrefetcher::Miss:
+        break;
+    }
+
     QUrl url(GEOCODING_API_URL);
     QUrlQuery query;
     query.addQueryItem("name", city);
@@ -134,15 +310,9 @@ void MainWindow::searchCity()
     url.setQuery(query);
 
     QNetworkRequest request = createRequest(url);
-    QNetworkReply *reply = m_networkManager->get(request);
-
-    m_searchReplies.insert(reply);
-}
-
-void MainWindow::onSslErrors(QNetworkReply *reply, const QList<QSslError> &errors)
-{
-    Q_UNUSED(errors)
-    reply->ignoreSslErrors();
+    m_service->scheduler()->get(request, RequestScheduler::Interactive, city, this, [this](QNetworkReply *reply) {
+        onSearchFinished(reply);
+    });
 }
 
 QNetworkRequest MainWindow::createRequest(const QUrl &url)
@@ -159,8 +329,6 @@ QNetworkRequest MainWindow::createRequest(const QUrl &url)
 
 void MainWindow::onSearchFinished(QNetworkReply *reply)
 {
-    reply->deleteLater();
-
     if (reply->error() != QNetworkReply::NoError) {
         QMessageBox::warning(this, TR("Search/network_error"),
                            TR("Search/failed_to_find") + reply->errorString());
@@ -180,206 +348,211 @@ void MainWindow::onSearchFinished(QNetworkReply *reply)
     QJsonObject city = results[0].toObject();
     QString cityName = city["name"].toString();
     QString country = city["country"].toString();
-    m_currentCity = cityName + ", " + country;
 
-    fetchWeather(m_currentCity);
-    fetchForecast(m_currentCity);
+    // Координаты уже есть в ответе геокодера - повторный запрос не нужен
+    GeoPoint point;
+    point.lat = city["latitude"].toDouble();
+    point.lon = city["longitude"].toDouble();
+    m_service->setPosition(cityName + ", " + country, point);
+
+    showCity(cityName + ", " + country);
 }
 
-void MainWindow::fetchWeather(const QString &city)
+void MainWindow::loadCoordinates(const GeoPoint &point)
 {
-    qDebug() << "Fetching weather for:" << city;
-
-    QStringList parts = city.split(", ");
-    if (parts.isEmpty()) return;
-
-    QUrl geoUrl(GEOCODING_API_URL);
-    QUrlQuery geoQuery;
-    geoQuery.addQueryItem("name", parts[0]);
-    geoQuery.addQueryItem("count", "1");
-    geoQuery.addQueryItem("language", getCurrentLanguageCode());
-    geoQuery.addQueryItem("format", "json");
-    geoUrl.setQuery(geoQuery);
-
-    qDebug() << "Geocoding URL:" << geoUrl.toString();
-
-    QNetworkRequest request = createRequest(geoUrl);
-    QNetworkReply *geoReply = m_networkManager->get(request);
+    double distance = 0;
+    const CityRecord *nearest = m_cityIndex.nearest(point, &distance);
+    if (nearest) {
+        qDebug() << "Nearest city:" << nearest->name << "distance km:" << distance;
+    }
 
-    connect(geoReply, &QNetworkReply::finished, this, [this, geoReply]() {
-        geoReply->deleteLater();
+    // Ключ места не зависит от языка: город рядом с точкой или сами координаты.
+    // "Около города" - только подпись, её строит locationLabel
+    QString city;
+    if (nearest && distance <= CITY_RADIUS_KM) {
+        city = nearest->name + ", " + nearest->country;
+    } else {
+        city = QString::number(point.lat, 'f', 4) + ", " + QString::number(point.lon, 'f', 4);
+    }
 
-        if (geoReply->error() != QNetworkReply::NoError) {
-            qDebug() << "Geo error:" << geoReply->errorString();
-            return;
-        }
+    // Погода - по введённой точке, а не по центру ближайшего города
+    m_service->setPosition(city, point);
+    showCity(city);
+}
 
-        QByteArray geoData = geoReply->readAll();
-        qDebug() << "Geocoding response:" << geoData;
+QString MainWindow::locationLabel(const QString &location) const
+{
+    GeoPoint point;
+    if (!CityIndex::parseCoordinates(location, &point)) return location;
 
-        QJsonDocument doc = QJsonDocument::fromJson(geoData);
-        QJsonObject obj = doc.object();
-        QJsonArray results = obj["results"].toArray();
+    double distance = 0;
+    const CityRecord *nearest = m_cityIndex.nearest(point, &distance);
+    if (!nearest || distance > NEAR_CITY_RADIUS_KM) return location;
 
-        if (!results.isEmpty()) {
-            QJsonObject location = results[0].toObject();
-            double lat = location["latitude"].toDouble();
-            double lon = location["longitude"].toDouble();
+    return TR("Search/near_city").arg(nearest->name + ", " + nearest->country).arg(qRound(distance));
+}
 
-            qDebug() << "Got coordinates:" << lat << lon;
+bool MainWindow::startServer(quint16 port)
+{
+    if (m_server) return true;
 
-            QUrl url(WEATHER_API_URL);
-            QUrlQuery query;
-            query.addQueryItem("latitude", QString::number(lat));
-            query.addQueryItem("longitude", QString::number(lon));
-            query.addQueryItem("current", "temperature_2m,relative_humidity_2m,apparent_temperature,weather_code,wind_speed_10m");
-            query.addQueryItem("timezone", "auto");
-            url.setQuery(query);
+    m_server = new WeatherServer(m_service, this);
 
-            QNetworkRequest weatherRequest = createRequest(url);
-            m_networkManager->get(weatherRequest);
-        } else {
-            qDebug() << "No geocoding results found";
+    // Сервер отдаёт то же, что видно в окне: текущий город и избранное
+    m_server->setLocationsProvider([this]() {
+        QStringList cities;
+        if (m_hasPosition && !m_currentCity.isEmpty()) {
+            cities << m_currentCity;
+        }
+        const QStringList favorites = m_favoritesModel->cities();
+        for (const QString &city : favorites) {
+            if (!cities.contains(city)) cities << city;
         }
+        return cities;
     });
+    m_server->setLocationResolver([this](const QString &city, GeoPoint *point) {
+        if (m_hasPosition && city == m_currentCity) {
+            *point = m_currentPosition;
+            return true;
+        }
+        if (!m_favoritesModel->contains(city)) return false;
+        return m_service->position(city, point);
+    });
+
+    if (!m_server->listen(port)) {
+        delete m_server;
+        m_server = nullptr;
+        return false;
+    }
+    return true;
 }
 
-void MainWindow::onWeatherFinished(QNetworkReply *reply)
+void MainWindow::activate(const QString &location)
 {
-    reply->deleteLater();
-
-    if (reply->error() != QNetworkReply::NoError) {
-        qDebug() << "Weather error:" << reply->errorString();
-        return;
+    if (isMinimized()) {
+        showNormal();
     }
+    show();
+    raise();
+    activateWindow();
 
-    QByteArray responseData = reply->readAll();
-    qDebug() << "Weather response received, size:" << responseData.size();
+    if (location.isEmpty()) return;
 
-    QJsonDocument doc = QJsonDocument::fromJson(responseData);
-    QJsonObject obj = doc.object();
-    QJsonObject current = obj["current"].toObject();
-
-    if (current.isEmpty()) {
-        qDebug() << "Current weather data is empty!";
-        return;
+    // Тот же путь, что и ручной ввод: координаты, подсказки, кэши уже прогреты
+    {
+        QSignalBlocker blocker(ui->m_searchInput);
+        ui->m_searchInput->setText(location);
     }
+    searchCity();
+}
 
-    WeatherData data;
-    data.city = m_currentCity;
-    data.temp = current["temperature_2m"].toDouble();
-    data.feelsLike = current["apparent_temperature"].toDouble();
-    data.humidity = current["relative_humidity_2m"].toInt();
-    data.windSpeed = current["wind_speed_10m"].toDouble();
-
-    int weatherCode = current["weather_code"].toInt();
-    data.weatherCode = weatherCode;
-    data.description = getWeatherDescription(weatherCode);
-
-    qDebug() << "Weather data:" << data.city << data.temp << data.description;
-
-    m_currentWeatherData = data;
-    m_hasWeatherData = true;
+void MainWindow::showCity(const QString &city)
+{
+    m_currentCity = city;
+    m_startupLoadPending = false;
+    m_hasPosition = m_service->position(city, &m_currentPosition);
 
-    displayWeather(data);
+    // Окно следит за одним городом; координаты при необходимости разрешит сервис
+    if (m_citySubscription) {
+        m_service->unsubscribe(m_citySubscription);
+    }
+    m_citySubscription = m_service->subscribe(city, WeatherService::Full, this, [this](const WeatherResult &result) {
+        onCityResult(result);
+    });
 }
 
-void MainWindow::fetchForecast(const QString &city)
+void MainWindow::onCityResult(const WeatherResult &result)
 {
-    qDebug() << "Fetching forecast for:" << city;
-
-    QStringList parts = city.split(", ");
-    if (parts.isEmpty()) return;
+    // Пока шли запросы, пользователь мог выбрать другой город
+    if (result.location() != m_currentCity) return;
 
-    QUrl geoUrl(GEOCODING_API_URL);
-    QUrlQuery geoQuery;
-    geoQuery.addQueryItem("name", parts[0]);
-    geoQuery.addQueryItem("count", "1");
-    geoQuery.addQueryItem("language", getCurrentLanguageCode());
-    geoQuery.addQueryItem("format", "json");
-    geoUrl.setQuery(geoQuery);
+    m_currentResult = result;
+    m_currentPosition = result.position();
+    m_hasPosition = true;
 
-    QNetworkRequest request = createRequest(geoUrl);
-    QNetworkReply *geoReply = m_networkManager->get(request);
+    displayWeather(result);
+    displayForecast(result.daily());
 
-    connect(geoReply, &QNetworkReply::finished, this, [this, geoReply]() {
-        geoReply->deleteLater();
+    // Смена города сбрасывает буфер; при том же городе хватает таймера
+    if (m_nowcastMode && nowcast()->setLocation(result.current().locationId, m_currentPosition)) {
+        nowcast()->refresh();
+    }
 
-        if (geoReply->error() != QNetworkReply::NoError) {
-            qDebug() << "Forecast geo error:" << geoReply->errorString();
-            return;
-        }
+    // Модели запрашиваются при смене города и не чаще расписания сервиса
+    bool ensembleStale = m_ensembleCity != m_currentCity
+            || QDateTime::currentMSecsSinceEpoch() - m_ensembleFetchedAt > 10 * 60 * 1000;
+    if (m_ensembleMode && ensembleStale) {
+        fetchEnsemble(m_currentPosition);
+    }
+}
 
-        QByteArray geoData = geoReply->readAll();
-        QJsonDocument doc = QJsonDocument::fromJson(geoData);
-        QJsonObject obj = doc.object();
-        QJsonArray results = obj["results"].toArray();
-
-        if (!results.isEmpty()) {
-            QJsonObject location = results[0].toObject();
-            double lat = location["latitude"].toDouble();
-            double lon = location["longitude"].toDouble();
-
-            qDebug() << "Got forecast coordinates:" << lat << lon;
-
-            QUrl url(WEATHER_API_URL);
-            QUrlQuery query;
-            query.addQueryItem("latitude", QString::number(lat));
-            query.addQueryItem("longitude", QString::number(lon));
-            query.addQueryItem("daily", "temperature_2m_max,temperature_2m_min,weather_code");
-            query.addQueryItem("timezone", "auto");
-            query.addQueryItem("forecast_days", "5");
-            url.setQuery(query);
-
-            QNetworkRequest forecastRequest = createRequest(url);
-            m_networkManager->get(forecastRequest);
-        } else {
-            qDebug() << "No forecast geocoding results found";
-        }
-    });
+void MainWindow::onWeatherResult(const WeatherResult &result)
+{
+    // Один раз на загрузку, сколько бы представлений ни следили за городом
+    recordObservation(result);
+    m_alertEngine->update(result.location(), alertSample(result));
 }
 
-void MainWindow::onForecastFinished(QNetworkReply *reply)
+void MainWindow::fetchEnsemble(const GeoPoint &point)
 {
-    reply->deleteLater();
+    const QStringList models = EnsembleForecast::defaultModels();
 
-    if (reply->error() != QNetworkReply::NoError) {
-        qDebug() << "Forecast error:" << reply->errorString();
-        return;
-    }
+    // Все модели одним запросом: каждая приходит своим столбцом hourly
+    QUrl url(WEATHER_API_URL);
+    QUrlQuery query;
+    query.addQueryItem("latitude", QString::number(point.lat));
+    query.addQueryItem("longitude", QString::number(point.lon));
+    query.addQueryItem("hourly", "temperature_2m");
+    query.addQueryItem("models", models.join(','));
+    query.addQueryItem("forecast_days", "5");
+    query.addQueryItem("timezone", "auto");
+    query.addQueryItem("timeformat", "unixtime");
+    url.setQuery(query);
 
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
-    QJsonObject obj = doc.object();
-    QJsonObject daily = obj["daily"].toObject();
+    QNetworkRequest request = createRequest(url);
 
-    QJsonArray times = daily["time"].toArray();
-    QJsonArray tempMax = daily["temperature_2m_max"].toArray();
-    QJsonArray tempMin = daily["temperature_2m_min"].toArray();
-    QJsonArray weatherCodes = daily["weather_code"].toArray();
+    QString city = m_currentCity;
+    m_ensembleCity = city;
+    m_ensembleFetchedAt = QDateTime::currentMSecsSinceEpoch();
+    m_service->scheduler()->get(request, RequestScheduler::CurrentCity, city, this,
+                                [this, city, models](QNetworkReply *reply) {
+        if (m_currentCity != city) return;
 
-    QList<ForecastData> forecast;
-    for (int i = 0; i < times.size(); ++i) {
-        ForecastData fd;
-        fd.dateTime = QDateTime::fromString(times[i].toString(), Qt::ISODate);
-        fd.tempMax = tempMax[i].toDouble();
-        fd.tempMin = tempMin[i].toDouble();
+        if (reply->error() != QNetworkReply::NoError) {
+            qDebug() << "Ensemble error:" << reply->errorString();
+            return;
+        }
 
-        int code = weatherCodes[i].toInt();
-        fd.weatherCode = code;
-        fd.description = getWeatherDescription(code);
+        QElapsedTimer timer;
+        timer.start();
 
-        forecast.append(fd);
-    }
+        EnsembleSeries series;
+        if (!EnsembleForecast::parse(QJsonDocument::fromJson(reply->readAll()).object(),
+                                     models, "temperature_2m", &series)) {
+            qDebug() << "Ensemble response has no model columns";
+            return;
+        }
+        qint64 parseNs = timer.nsecsElapsed();
+        EnsembleForecast::computeStats(&series);
+        series.locationId = m_service->locations().intern(city);
+
+        qDebug() << "Ensemble models:" << series.models << "steps:" << series.steps
+                 << "parse ms:" << parseNs / 1000000.0
+                 << "stats ms:" << (timer.nsecsElapsed() - parseNs) / 1000000.0;
 
-    m_currentForecastData = forecast;
-    displayForecast(forecast);
+        m_currentEnsemble = series;
+        displayForecast(m_currentResult.daily());
+    });
 }
 
-void MainWindow::displayWeather(const WeatherData &data)
+void MainWindow::displayWeather(const WeatherResult &result)
 {
-    ui->m_cityLabel->setText(data.city);
+    const WeatherData &data = result.current();
+    const SnapshotExtras &currentExtras = result.extras();
+
+    ui->m_cityLabel->setText(locationLabel(result.location()));
     ui->m_tempLabel->setText(QString::number(convertTemp(data.temp), 'f', 1) + getTempUnit());
-    ui->m_descLabel->setText(data.description);
+    ui->m_descLabel->setText(getWeatherDescription(data.weatherCode));
 
     ui->m_feelsLikeLabel->setText(TR("Weather/feels_like") +
                                   QString::number(convertTemp(data.feelsLike), 'f', 1) + getTempUnit());
@@ -389,11 +562,27 @@ void MainWindow::displayWeather(const WeatherData &data)
     ui->m_windLabel->setText("💨 " + TR("Weather/wind") +
                             QString::number(convertSpeed(data.windSpeed), 'f', 1) + " " + getSpeedUnit());
 
-    QString icon = getWeatherIcon(data.description);
-    ui->m_iconLabel->setText(icon);
+    ui->m_iconLabel->setPixmap(getWeatherIcon(data.weatherCode, 96));
+
+    // Качество воздуха и волны - только то, что пришло (волны есть лишь у побережья)
+    QStringList extras;
+    if (!qIsNaN(currentExtras.pm25)) {
+        QString air = "🌫 " + TR("Weather/pm25") + QString::number(currentExtras.pm25, 'f', 0) + " µg/m³";
+        if (!qIsNaN(currentExtras.usAqi)) {
+            air += "  " + TR("Weather/aqi") + QString::number(currentExtras.usAqi, 'f', 0);
+        }
+        extras << air;
+    }
+    if (!qIsNaN(currentExtras.waveHeight)) {
+        double height = m_isCelsius ? currentExtras.waveHeight : currentExtras.waveHeight * 3.281;
+        extras << "🌊 " + TR("Weather/waves") + QString::number(height, 'f', 1) + " "
+                  + (m_isCelsius ? TR("Weather/unit_m") : TR("Weather/unit_ft"));
+    }
+    ui->m_extraLabel->setText(extras.join("    "));
+    ui->m_extraLabel->setVisible(!extras.isEmpty());
 }
 
-void MainWindow::displayForecast(const QList<ForecastData> &forecast)
+void MainWindow::displayForecast(const QVector<ForecastData> &forecast)
 {
     QVBoxLayout *layout = qobject_cast<QVBoxLayout*>(ui->m_forecastFrame->layout());
 
@@ -404,26 +593,39 @@ void MainWindow::displayForecast(const QList<ForecastData> &forecast)
         delete item;
     }
 
-    for (const ForecastData &fd : forecast) {
-        QFrame *dayFrame = new QFrame();
-        dayFrame->setFrameStyle(QFrame::Box);
-        QHBoxLayout *dayLayout = new QHBoxLayout(dayFrame);
+    // Режим сравнения моделей: полосы разброса вместо строк по дням
+    bool showEnsemble = m_ensembleMode && m_currentEnsemble.locationId == m_service->locations().find(m_currentCity);
+    if (showEnsemble) {
+        EnsembleChart *chart = new EnsembleChart();
+        chart->setSeries(m_currentEnsemble, m_isCelsius);
+        layout->addWidget(chart);
+    }
 
-        QString dayName = fd.dateTime.toString("ddd, d MMM");
+    // Почасовые данные привязаны к месту: при смене города раскрытые дни сбрасываются
+    quint32 locationId = m_service->locations().intern(m_currentCity);
+    if (locationId != m_expandedLocation) {
+        m_expandedDays.clear();
+        m_expandedLocation = locationId;
+    }
+    detailLoader()->setLocation(locationId, m_currentPosition);
+
+    const QVector<ForecastData> rows = showEnsemble ? QVector<ForecastData>() : forecast;
+    for (const ForecastData &fd : rows) {
+        ForecastDayRow *dayFrame = new ForecastDayRow(fd.time);
+        QHBoxLayout *dayLayout = dayFrame->summaryLayout();
+        connect(dayFrame, &ForecastDayRow::toggled, this, &MainWindow::onForecastDayToggled);
+
+        QString dayName = QDateTime::fromSecsSinceEpoch(fd.time, Qt::UTC).toString("ddd, d MMM");
         QLabel *dateLabel = new QLabel(dayName);
         dateLabel->setMinimumWidth(120);
         QFont dateFont = dateLabel->font();
         dateFont.setPointSize(12);
         dateLabel->setFont(dateFont);
 
-        QString icon = getWeatherIcon(fd.description);
+        QLabel *iconLabel = new QLabel();
+        iconLabel->setPixmap(getWeatherIcon(fd.weatherCode, 32));
 
-        QLabel *iconLabel = new QLabel(icon);
-        QFont iconFont = iconLabel->font();
-        iconFont.setPointSize(24);
-        iconLabel->setFont(iconFont);
-
-        QLabel *descLabel = new QLabel(fd.description);
+        QLabel *descLabel = new QLabel(getWeatherDescription(fd.weatherCode));
         descLabel->setMinimumWidth(90);
         QFont descFontForecast = descLabel->font();
         descFontForecast.setPointSize(12);
@@ -443,10 +645,74 @@ void MainWindow::displayForecast(const QList<ForecastData> &forecast)
         dayLayout->addStretch();
         dayLayout->addWidget(tempLabel);
 
+        if (m_expandedDays.contains(fd.time)) {
+            dayFrame->setExpanded(true);
+            QVector<HourlyPoint> points;
+            if (detailLoader()->cached(fd.time, &points)) {
+                dayFrame->setDetail(points, m_isCelsius);
+            } else {
+                dayFrame->setLoading();
+            }
+        }
+
         layout->addWidget(dayFrame);
     }
 
     layout->addStretch();
+
+    // Детализация раскрытых дней грузится, когда станет известна их видимость
+    QTimer::singleShot(0, this, &MainWindow::updateDetailLoads);
+}
+
+void MainWindow::onForecastDayToggled(qint64 day, bool expanded)
+{
+    ForecastDayRow *row = qobject_cast<ForecastDayRow*>(sender());
+
+    if (!expanded) {
+        m_expandedDays.remove(day);
+        detailLoader()->cancel(day);
+        return;
+    }
+
+    m_expandedDays.insert(day);
+    QVector<HourlyPoint> points;
+    if (detailLoader()->cached(day, &points)) {
+        row->setDetail(points, m_isCelsius);
+    } else {
+        row->setLoading();
+        updateDetailLoads();
+    }
+}
+
+void MainWindow::updateDetailLoads()
+{
+    QWidget *viewport = ui->m_scrollArea->viewport();
+    const QList<ForecastDayRow*> rows = ui->m_forecastFrame->findChildren<ForecastDayRow*>();
+
+    for (ForecastDayRow *row : rows) {
+        if (!row->isExpanded()) continue;
+
+        QRect area(row->mapTo(viewport, QPoint(0, 0)), row->size());
+        bool visible = viewport->rect().intersects(area);
+        QVector<HourlyPoint> points;
+
+        // Загружаем только видимые раскрытые дни; ушедшие из виду загрузки отменяем
+        if (visible && !detailLoader()->isLoading(row->day()) && !detailLoader()->cached(row->day(), &points)) {
+            detailLoader()->load(row->day());
+        } else if (!visible && detailLoader()->isLoading(row->day())) {
+            detailLoader()->cancel(row->day());
+        }
+    }
+}
+
+void MainWindow::onForecastDetailLoaded(qint64 day, const QVector<HourlyPoint> &points)
+{
+    const QList<ForecastDayRow*> rows = ui->m_forecastFrame->findChildren<ForecastDayRow*>();
+    for (ForecastDayRow *row : rows) {
+        if (row->day() == day) {
+            row->setDetail(points, m_isCelsius);
+        }
+    }
 }
 
 void MainWindow::addToFavorites()
@@ -456,31 +722,34 @@ void MainWindow::addToFavorites()
         return;
     }
 
-    if (m_favoriteCities.contains(m_currentCity)) {
+    if (m_favoritesModel->contains(m_currentCity)) {
         QMessageBox::information(this, TR("Favorites/info_title"), TR("Favorites/already_added"));
         return;
     }
 
-    m_favoriteCities.append(m_currentCity);
-    updateFavoritesList();
-    saveSettings();
+    m_favoritesModel->append(m_currentCity);
+    m_favoritesStore->addFavorite(m_currentCity);
+    if (m_hasPosition) {
+        m_favoritesStore->saveCoordinates(m_currentCity, m_currentPosition.lat, m_currentPosition.lon);
+    }
+    watchFavorite(m_currentCity);
 }
 
 void MainWindow::removeFromFavorites()
 {
-    QListWidgetItem *item = ui->m_favoritesList->currentItem();
-    if (!item) return;
-
-    m_favoriteCities.removeAll(item->text());
-    updateFavoritesList();
-    saveSettings();
+    QModelIndex index = ui->m_favoritesList->currentIndex();
+    if (!index.isValid()) return;
+
+    QString city = index.data(FavoritesModel::CityRole).toString();
+    m_favoritesModel->remove(city);
+    m_favoritesStore->removeFavorite(city);
+    m_alertEngine->forget(city);
+    m_service->unsubscribe(m_favoriteSubscriptions.take(city));
 }
 
 void MainWindow::loadFavoriteCity(const QString &city)
 {
-    m_currentCity = city;
-    fetchWeather(city);
-    fetchForecast(city);
+    showCity(city);
 }
 
 void MainWindow::toggleLanguage()
@@ -490,23 +759,23 @@ void MainWindow::toggleLanguage()
 
     // Загружаем новый язык
     Translator::instance().loadLanguage(m_currentLanguage);
+    m_service->setLanguage(m_currentLanguage);
 
     updateLanguage();
 
     // Перерисовываем данные с новым языком если они есть
-    if (m_hasWeatherData) {
-        // Обновляем описания погоды на основе сохраненных кодов
-        m_currentWeatherData.description = getWeatherDescription(m_currentWeatherData.weatherCode);
-        displayWeather(m_currentWeatherData);
-
-        // Обновляем описания прогноза
-        for (int i = 0; i < m_currentForecastData.size(); ++i) {
-            m_currentForecastData[i].description = getWeatherDescription(m_currentForecastData[i].weatherCode);
-        }
-        displayForecast(m_currentForecastData);
-    }
+    redisplayWeather();
 
-    saveSettings();
+    m_settings->setValue("language", m_currentLanguage);
+}
+
+void MainWindow::redisplayWeather()
+{
+    if (!m_currentResult.isValid()) return;
+
+    // Описания выводятся из кодов при отрисовке - на текущем языке
+    displayWeather(m_currentResult);
+    displayForecast(m_currentResult.daily());
 }
 
 void MainWindow::updateLanguage()
@@ -521,11 +790,22 @@ void MainWindow::updateLanguage()
     ui->m_favoriteButton->setToolTip(TR("Favorites/add_tooltip"));
     ui->m_refreshButton->setToolTip(TR("Controls/refresh_tooltip"));
     ui->m_languageButton->setToolTip(TR("Controls/language_tooltip"));
+    ui->m_themeButton->setToolTip(TR("Controls/theme_tooltip"));
     ui->m_unitsCombo->setItemText(0, "°C, " + TR("Weather/speed_ms"));
     ui->m_unitsCombo->setItemText(1, "°F, " + TR("Weather/speed_mph"));
     ui->forecastTitle->setText("📅 " + TR("Forecast/title"));
     ui->favoritesTitle->setText("⭐ " + TR("Favorites/title"));
     ui->removeFavButton->setText(TR("Favorites/remove_button"));
+    m_viewMenu->setTitle(TR("Menu/view"));
+    m_historyAction->setText(TR("Menu/history"));
+    m_climateAction->setText(TR("Menu/climate"));
+    m_heatmapAction->setText(TR("Menu/heatmap"));
+    m_alertsAction->setText(TR("Menu/alerts"));
+    m_ensembleAction->setText(TR("Menu/ensemble"));
+    m_nowcastAction->setText(TR("Menu/nowcast"));
+    if (m_nowcastChart) {
+        m_nowcastChart->update();
+    }
 
     if (m_currentCity.isEmpty()) {
         ui->m_cityLabel->setText(TR("General/select_city"));
@@ -535,19 +815,199 @@ void MainWindow::updateLanguage()
 void MainWindow::toggleUnits()
 {
     m_isCelsius = (ui->m_unitsCombo->currentIndex() == 0);
-
-    if (!m_currentCity.isEmpty()) {
-        refreshCurrentCity();
+    m_favoritesDelegate->setCelsius(m_isCelsius);
+    if (m_nowcastChart) {
+        m_nowcastChart->setCelsius(m_isCelsius);
     }
+    m_favoritesModel->refreshAll();
+
+    // Данные хранятся в метрических единицах - достаточно перерисовать
+    redisplayWeather();
 
-    saveSettings();
+    m_settings->setValue("celsius", m_isCelsius);
 }
 
 void MainWindow::refreshCurrentCity()
 {
-    if (!m_currentCity.isEmpty()) {
-        fetchWeather(m_currentCity);
-        fetchForecast(m_currentCity);
+    if (m_citySubscription) {
+        m_service->refresh(m_currentCity);
+    } else if (!m_currentCity.isEmpty()) {
+        showCity(m_currentCity);
+    }
+}
+
+void MainWindow::watchFavorite(const QString &city)
+{
+    if (m_favoriteSubscriptions.contains(city)) return;
+
+    // Избранному хватает краткого запроса; если город открыт в окне, загрузка общая
+    WeatherService::Subscription subscription = m_service->subscribe(city, WeatherService::Brief, this,
+                                                                     [this, city](const WeatherResult &result) {
+        const WeatherData &current = result.current();
+        m_favoritesModel->updateObservation(city, current.temp, current.weatherCode, result.hourlyTemps());
+        m_favoritesStore->saveObservation(city, current.temp, current.weatherCode, result.fetchedAt() / 1000);
+    });
+    m_favoriteSubscriptions.insert(city, subscription);
+}
+
+void MainWindow::recordObservation(const WeatherResult &result)
+{
+    const WeatherData &current = result.current();
+
+    HistoryRecord record;
+    record.timestamp = current.time;
+    record.temp = current.temp;
+    record.feelsLike = current.feelsLike;
+    record.humidity = current.humidity;
+    record.windSpeed = current.windSpeed;
+    record.weatherCode = current.weatherCode;
+
+    m_history.append(result.location(), record);
+}
+
+void MainWindow::showHistory()
+{
+    if (m_currentCity.isEmpty()) {
+        QMessageBox::warning(this, TR("Favorites/info_title"), TR("Favorites/select_first"));
+        return;
+    }
+
+    HistoryDialog *dialog = new HistoryDialog(&m_history, m_currentCity, m_isCelsius, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void MainWindow::showClimate()
+{
+    // Выбранное избранное важнее текущего города
+    QString city = ui->m_favoritesList->currentIndex().data(FavoritesModel::CityRole).toString();
+    if (city.isEmpty()) {
+        city = m_currentCity;
+    }
+    if (city.isEmpty()) {
+        QMessageBox::warning(this, TR("Favorites/info_title"), TR("Favorites/select_first"));
+        return;
+    }
+
+    m_service->resolve(city, RequestScheduler::Interactive, this, [this, city](const GeoPoint &point) {
+        ClimateDialog *dialog = new ClimateDialog(m_service->scheduler(), city, point, m_isCelsius, this);
+        dialog->setAttribute(Qt::WA_DeleteOnClose);
+        dialog->show();
+    });
+}
+
+void MainWindow::showHeatmap()
+{
+    if (!m_hasPosition) {
+        QMessageBox::warning(this, TR("Favorites/info_title"), TR("Favorites/select_first"));
+        return;
+    }
+
+    // Решётка общая для всех открытий: уже загруженные узлы не запрашиваются снова
+    if (!m_regionGrid) {
+        m_regionGrid = new RegionGrid(m_service->scheduler(), WEATHER_API_URL, this);
+    }
+
+    HeatmapDialog *dialog = new HeatmapDialog(m_regionGrid, m_currentCity, m_currentPosition, m_isCelsius, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void MainWindow::showAlerts()
+{
+    AlertsDialog dialog(m_alertEngine->rules(), this);
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    QStringList rules = dialog.rules();
+    m_alertEngine->setRules(rules);
+    m_settings->setValue("alertRules", rules);
+}
+
+void MainWindow::toggleEnsemble(bool enabled)
+{
+    m_ensembleMode = enabled;
+    m_settings->setValue("ensemble", enabled);
+
+    if (enabled && m_hasPosition) {
+        fetchEnsemble(m_currentPosition);
+    }
+    displayForecast(m_currentResult.daily());
+}
+
+void MainWindow::toggleNowcast(bool enabled)
+{
+    m_nowcastMode = enabled;
+    m_settings->setValue("nowcast", enabled);
+
+    if (!enabled) {
+        m_nowcastTimer->stop();
+        if (m_nowcastChart) {
+            m_nowcastChart->hide();
+        }
+        return;
+    }
+
+    // Панель встаёт под текущей погодой; сеть не трогаем, пока нет города
+    if (!m_nowcastChart) {
+        m_nowcastChart = new NowcastChart(m_nowcast ? &m_nowcast->buffer() : nullptr, ui->weatherFrame);
+        m_nowcastChart->setCelsius(m_isCelsius);
+        ui->weatherLayout->insertWidget(ui->weatherLayout->indexOf(ui->m_extraLabel) + 1, m_nowcastChart);
+    }
+    m_nowcastChart->show();
+    m_nowcastTimer->start();
+
+    if (m_currentResult.isValid()) {
+        nowcast()->setLocation(m_currentResult.current().locationId, m_currentPosition);
+        nowcast()->refresh();
+    }
+}
+
+void MainWindow::refreshNowcast()
+{
+    if (m_nowcast && m_nowcastMode) {
+        m_nowcast->refresh();
+    }
+}
+
+AlertSample MainWindow::alertSample(const WeatherResult &result) const
+{
+    const WeatherData &current = result.current();
+
+    AlertSample sample;
+    sample.values[AlertSample::Temperature] = current.temp;
+    sample.values[AlertSample::FeelsLike] = current.feelsLike;
+    sample.values[AlertSample::Humidity] = current.humidity;
+    sample.values[AlertSample::WindSpeed] = current.windSpeed;
+    sample.values[AlertSample::WeatherCode] = current.weatherCode;
+
+    // Сутки вперёд: худший код погоды и размах температур для правил оповещений
+    const QVector<quint8> &codes = result.hourlyCodes();
+    if (!codes.isEmpty()) {
+        sample.values[AlertSample::MaxCode24h] = *std::max_element(codes.constBegin(), codes.constEnd());
+    }
+    const QVector<float> &temps = result.hourlyTemps();
+    if (!temps.isEmpty()) {
+        sample.values[AlertSample::MinTemp24h] = *std::min_element(temps.constBegin(), temps.constEnd());
+        sample.values[AlertSample::MaxTemp24h] = *std::max_element(temps.constBegin(), temps.constEnd());
+    }
+    return sample;
+}
+
+void MainWindow::onAlertTriggered(const QString &location, const QString &rule, float value)
+{
+    QString message = TR("Alerts/fired").arg(rule).arg(QString::number(value, 'f', 1));
+
+    // Уведомление через трей; без трея - в строке состояния окна
+    if (QSystemTrayIcon::isSystemTrayAvailable()) {
+        if (!m_trayIcon) {
+            QIcon icon = windowIcon().isNull() ? QIcon(getWeatherIcon(95, 32)) : windowIcon();
+            m_trayIcon = new QSystemTrayIcon(icon, this);
+            connect(m_trayIcon, &QSystemTrayIcon::messageClicked, this, [this]() { activate(QString()); });
+            m_trayIcon->show();
+        }
+        m_trayIcon->showMessage(TR("Alerts/notification_title") + ": " + location, message);
+    } else {
+        statusBar()->showMessage(location + ": " + message, 30000);
     }
 }
 
@@ -569,14 +1029,21 @@ void MainWindow::performSearchSuggestions(const QString &text)
     query.addQueryItem("language", getCurrentLanguageCode());
     url.setQuery(query);
 
+    // Новые подсказки заменяют ещё не пришедшие старые
+    if (m_suggestionTicket) {
+        m_service->scheduler()->cancel(m_suggestionTicket);
+    }
+
     QNetworkRequest request = createRequest(url);
-    m_networkManager->get(request);
+    m_suggestionTicket = m_service->scheduler()->get(request, RequestScheduler::Interactive, "suggestions", this,
+                                                     [this](QNetworkReply *reply) {
+        m_suggestionTicket = 0;
+        onSuggestionsFinished(reply);
+    });
 }
 
 void MainWindow::onSuggestionsFinished(QNetworkReply *reply)
 {
-    reply->deleteLater();
-
     if (reply->error() != QNetworkReply::NoError) {
         return;
     }
@@ -585,199 +1052,140 @@ void MainWindow::onSuggestionsFinished(QNetworkReply *reply)
     QJsonArray results = doc.object()["results"].toArray();
 
     QStringList suggestions;
+    QList<PrefetchCandidate> candidates;
     for (const QJsonValue &val : results) {
         QJsonObject obj = val.toObject();
-        suggestions << obj["name"].toString() + ", " + obj["country"].toString();
+        QString city = obj["name"].toString() + ", " + obj["country"].toString();
+        suggestions << city;
+
+        PrefetchCandidate candidate;
+        candidate.city = city;
+        candidate.position.lat = obj["latitude"].toDouble();
+        candidate.position.lon = obj["longitude"].toDouble();
+        candidates.append(candidate);
     }
 
+    ensureCompleter();
     m_completerModel->setStringList(suggestions);
+
+    // Подсказки устоялись: первые города загружаем заранее по их координатам
+    prefetcher()->prefetch(candidates);
+}
+
+void MainWindow::onPrefetchReady(const QString &city, const QJsonObject &response, const GeoPoint &position)
+{
+    // Пока ждали ответ, пользователь мог уйти на другой город
+    if (m_currentCity != city) return;
+
+    // Неудачная предзагрузка приходит без ответа, а координаты (0, 0) - не город:
+    // в этих случаях сервис сам геокодирует и загрузит погоду
+    bool hasPosition = position.lat != 0.0 || position.lon != 0.0;
+    if (!response.isEmpty() && hasPosition) {
+        m_service->setPosition(city, position);
+        m_service->ingest(city, response);
+    }
+    showCity(city);
 }
 
 void MainWindow::applyTheme()
 {
-    QString theme = R"(
-        QMainWindow {
-            background-color: #0d0d0d;
-        }
-        QWidget {
-            background-color: #0d0d0d;
-            color: #ffffff;
-        }
-        QWidget#centralWidget {
-            background-color: #0d0d0d;
-        }
-        QLabel {
-            color: #ffffff;
-            background-color: transparent;
-        }
-        QFrame {
-            background-color: #1a1a1a;
-            color: #ffffff;
-            border: 1px solid #2d2d2d;
-            border-radius: 8px;
-        }
-        QFrame#weatherFrame, QFrame#favoritesFrame {
-            background-color: #1a1a1a;
-            border: 1px solid #2d2d2d;
-        }
-        QLineEdit {
-            background-color: #2d2d2d;
-            color: #ffffff;
-            border: 1px solid #404040;
-            border-radius: 4px;
-            padding: 5px;
-            selection-background-color: #0d7377;
-        }
-        QLineEdit:focus {
-            border: 1px solid #0d7377;
-        }
-        QComboBox {
-            background-color: #2d2d2d;
-            color: #ffffff;
-            border: 1px solid #404040;
-            border-radius: 4px;
-            padding: 5px;
-        }
-        QComboBox:hover {
-            border: 1px solid #0d7377;
-        }
-        QComboBox::drop-down {
-            border: none;
-            width: 20px;
-        }
-        QComboBox QAbstractItemView {
-            background-color: #2d2d2d;
-            color: #ffffff;
-            selection-background-color: #0d7377;
-            border: 1px solid #404040;
-        }
-        QPushButton {
-            background-color: #0d7377;
-            color: #ffffff;
-            border: none;
-            border-radius: 4px;
-            padding: 8px 16px;
-            font-weight: bold;
-        }
-        QPushButton:hover {
-            background-color: #14a085;
-        }
-        QPushButton:pressed {
-            background-color: #0a5a5d;
-        }
-        QListWidget {
-            background-color: #1a1a1a;
-            color: #ffffff;
-            border: 1px solid #2d2d2d;
-            border-radius: 4px;
-            outline: none;
-        }
-        QListWidget::item {
-            color: #ffffff;
-            padding: 8px;
-            border-bottom: 1px solid #2d2d2d;
-        }
-        QListWidget::item:selected {
-            background-color: #0d7377;
-            color: #ffffff;
-        }
-        QListWidget::item:hover {
-            background-color: #2d2d2d;
-        }
-        QScrollArea {
-            background-color: #0d0d0d;
-            border: none;
-        }
-        QScrollArea > QWidget > QWidget {
-            background-color: #0d0d0d;
-        }
-        QScrollBar:vertical {
-            background-color: #1a1a1a;
-            width: 12px;
-            border: none;
-        }
-        QScrollBar::handle:vertical {
-            background-color: #404040;
-            border-radius: 6px;
-            min-height: 20px;
-        }
-        QScrollBar::handle:vertical:hover {
-            background-color: #505050;
-        }
-        QScrollBar::add-line:vertical, QScrollBar::sub-line:vertical {
-            height: 0px;
-        }
-        QScrollBar:horizontal {
-            background-color: #1a1a1a;
-            height: 12px;
-            border: none;
-        }
-        QScrollBar::handle:horizontal {
-            background-color: #404040;
-            border-radius: 6px;
-            min-width: 20px;
-        }
-        QScrollBar::handle:horizontal:hover {
-            background-color: #505050;
-        }
-        QScrollBar::add-line:horizontal, QScrollBar::sub-line:horizontal {
-            width: 0px;
-        }
-        QMenuBar {
-            background-color: #1a1a1a;
-            color: #ffffff;
-            border-bottom: 1px solid #2d2d2d;
-        }
-        QMenuBar::item {
-            background-color: transparent;
-            padding: 4px 8px;
-        }
-        QMenuBar::item:selected {
-            background-color: #2d2d2d;
-        }
-        QToolBar {
-            background-color: #1a1a1a;
-            border: none;
-            spacing: 3px;
-        }
-        QStatusBar {
-            background-color: #1a1a1a;
-            color: #ffffff;
-            border-top: 1px solid #2d2d2d;
-        }
-    )";
+    ThemeEngine::apply(m_theme);
+    ui->m_themeButton->setText(m_theme == ThemeEngine::Dark ? "🌙" : "☀️");
 
-    setStyleSheet(theme);
+    // Список избранного окрашен как панели, а не как поле ввода
+    ui->m_favoritesList->viewport()->setBackgroundRole(QPalette::AlternateBase);
 }
 
-void MainWindow::updateFavoritesList()
+void MainWindow::toggleTheme()
 {
-    ui->m_favoritesList->clear();
-    ui->m_favoritesList->addItems(m_favoriteCities);
+    m_theme = (m_theme == ThemeEngine::Dark) ? ThemeEngine::Light : ThemeEngine::Dark;
+    applyTheme();
+    m_settings->setValue("theme", ThemeEngine::toString(m_theme));
 }
 
 void MainWindow::loadSettings()
 {
-    m_favoriteCities = m_settings->value("favorites").toStringList();
+    // Избранное из старых версий переносим в хранилище один раз
+    if (m_settings->contains("favorites")) {
+        const QStringList legacy = m_settings->value("favorites").toStringList();
+        for (const QString &city : legacy) {
+            m_favoritesStore->addFavorite(city);
+        }
+        m_favoritesStore->flush();
+        m_settings->remove("favorites");
+        qDebug() << "Migrated favorites from settings:" << legacy.size();
+    }
+
+    // Список избранного читается в потоке хранилища и приходит страницами
+    connect(m_favoritesStore, &FavoritesStore::pageLoaded, this, &MainWindow::onFavoritesPageLoaded);
+    m_favoritesStore->load();
+
     m_currentCity = m_settings->value("lastCity").toString();
     // m_currentLanguage уже загружен в конструкторе
     m_isCelsius = m_settings->value("celsius", true).toBool();
+    m_theme = ThemeEngine::fromString(m_settings->value("theme", "dark").toString());
+    m_alertEngine->setRules(m_settings->value("alertRules").toStringList());
+    m_ensembleMode = m_settings->value("ensemble", false).toBool();
+    m_nowcastMode = m_settings->value("nowcast", false).toBool();
+
+    if (!m_currentCity.isEmpty() && m_settings->contains("lastLat") && m_settings->contains("lastLon")) {
+        m_currentPosition.lat = m_settings->value("lastLat").toDouble();
+        m_currentPosition.lon = m_settings->value("lastLon").toDouble();
+        m_hasPosition = true;
+        m_service->setPosition(m_currentCity, m_currentPosition);
+    }
 
     qDebug() << "Settings loaded:";
-    qDebug() << "  Favorites count:" << m_favoriteCities.size();
     qDebug() << "  Last city:" << m_currentCity;
     qDebug() << "  Celsius:" << m_isCelsius;
 
-    updateFavoritesList();
+    m_favoritesDelegate->setCelsius(m_isCelsius);
     ui->m_unitsCombo->setCurrentIndex(m_isCelsius ? 0 : 1);
 }
 
-void MainWindow::saveSettings()
+void MainWindow::saveLastLocation()
 {
-    m_settings->setValue("favorites", m_favoriteCities);
     m_settings->setValue("lastCity", m_currentCity);
-    m_settings->setValue("language", m_currentLanguage);
-    m_settings->setValue("celsius", m_isCelsius);
+    if (m_hasPosition) {
+        m_settings->setValue("lastLat", m_currentPosition.lat);
+        m_settings->setValue("lastLon", m_currentPosition.lon);
+    } else {
+        m_settings->remove("lastLat");
+        m_settings->remove("lastLon");
+    }
+}
+
+void MainWindow::onFavoritesPageLoaded(const QList<StoredFavorite> &page, bool last)
+{
+    QVector<FavoriteEntry> entries;
+    entries.reserve(page.size());
+
+    for (const StoredFavorite &fav : page) {
+        FavoriteEntry entry;
+        entry.city = fav.city;
+        entry.hasData = fav.hasObservation;
+        entry.temp = fav.temp;
+        entry.weatherCode = fav.weatherCode;
+        entries.append(entry);
+
+        // Сохранённые координаты избавляют от геокодирования при обновлении
+        if (fav.hasCoordinates) {
+            GeoPoint point;
+            point.lat = fav.lat;
+            point.lon = fav.lon;
+            m_service->setPosition(fav.city, point);
+        }
+    }
+
+    m_favoritesModel->appendEntries(entries);
+
+    if (last) {
+        qDebug() << "Favorites loaded:" << m_favoritesModel->rowCount();
+        const QStringList cities = m_favoritesModel->cities();
+        for (const QString &city : cities) {
+            watchFavorite(city);
+        }
+    }
 }
 
 double MainWindow::convertTemp(double temp)
@@ -809,19 +1217,10 @@ QString MainWindow::getWeatherDescription(int code)
     else return TR("WeatherConditions/thunderstorm");
 }
 
-QString MainWindow::getWeatherIcon(const QString &description)
+QPixmap MainWindow::getWeatherIcon(int code, int size) const
 {
-    QString clear = TR("WeatherConditions/clear");
-    QString cloudy = TR("WeatherConditions/cloudy");
-    QString rain = TR("WeatherConditions/rain");
-    QString snow = TR("WeatherConditions/snow");
-    QString thunderstorm = TR("WeatherConditions/thunderstorm");
-
-    if (description == cloudy) return "☁️";
-    else if (description == rain) return "🌧️";
-    else if (description == snow) return "❄️";
-    else if (description == thunderstorm) return "⛈️";
-    else return "☀️";
+    return WeatherIconAtlas::instance().icon(WeatherIconAtlas::conditionForCode(code),
+                                             size, devicePixelRatioF());
 }
 
 QString MainWindow::getCurrentLanguageCode() const
@@ -829,7 +1228,3 @@ QString MainWindow::getCurrentLanguageCode() const
     return m_currentLanguage;
 }
 
-QString MainWindow::getWeatherIconUrl(const QString &icon)
-{
-    return "https://openweathermap.org/img/wn/" + icon + "@2x.png";
-}
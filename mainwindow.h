@@ -11,33 +11,32 @@
 #include <QTimer>
 #include <QCompleter>
 #include <QStringListModel>
+#include <functional>
+#include "cityindex.h"
+#include "themeengine.h"
+#include "favoritesmodel.h"
+#include "favoritesdelegate.h"
+#include "favoritesstore.h"
+#include "observationhistory.h"
+#include "suggestionprefetcher.h"
+#include "weatherserver.h"
+#include "alertengine.h"
+#include "weatherrecords.h"
+#include "ensembleforecast.h"
+#include "weatherservice.h"
+#include "forecastdetail.h"
+#include "requestscheduler.h"
+#include "regiongrid.h"
+#include "nowcast.h"
 
 namespace Ui {
 class MainWindow;
 }
 
-struct WeatherData {
-    QString city;
-    QString country;
-    double temp;
-    double feelsLike;
-    int humidity;
-    double windSpeed;
-    QString description;
-    QString icon;
-    QDateTime dateTime;
-    int weatherCode;
-};
-
-struct ForecastData {
-    QDateTime dateTime;
-    double temp;
-    double tempMin;
-    double tempMax;
-    QString description;
-    QString icon;
-    int weatherCode;
-};
+class QMenu;
+class QAction;
+class QSystemTrayIcon;
+class NowcastChart;
 
 class MainWindow : public QMainWindow
 {
@@ -47,63 +46,128 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    void loadCoordinates(const GeoPoint &point);
+    bool startServer(quint16 port);
+
+public slots:
+    // Запрос от повторного запуска: поднять окно и, если задано, открыть город или координаты
+    void activate(const QString &location);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+
 private slots:
     void searchCity();
     void onSearchFinished(QNetworkReply *reply);
     void onSuggestionsFinished(QNetworkReply *reply);
-    void onWeatherFinished(QNetworkReply *reply);
-    void onForecastFinished(QNetworkReply *reply);
+    void onPrefetchReady(const QString &city, const QJsonObject &response, const GeoPoint &position);
+    void onCityResult(const WeatherResult &result);
+    void onWeatherResult(const WeatherResult &result);
+    void onForecastDayToggled(qint64 day, bool expanded);
+    void onForecastDetailLoaded(qint64 day, const QVector<HourlyPoint> &points);
+    void updateDetailLoads();
     void addToFavorites();
     void removeFromFavorites();
     void loadFavoriteCity(const QString &city);
     void toggleLanguage();
     void toggleUnits();
+    void toggleTheme();
     void refreshCurrentCity();
+    void showHistory();
+    void showClimate();
+    void showHeatmap();
+    void showAlerts();
+    void toggleEnsemble(bool enabled);
+    void toggleNowcast(bool enabled);
+    void refreshNowcast();
+    void onAlertTriggered(const QString &location, const QString &rule, float value);
     void updateSearchSuggestions(const QString &text);
     void performSearchSuggestions(const QString &text);
-    void onSslErrors(QNetworkReply *reply, const QList<QSslError> &errors);
 
 private:
+    SuggestionPrefetcher *prefetcher();
+    ForecastDetailLoader *detailLoader();
+    NowcastFeed *nowcast();
+    void ensureCompleter();
+    void setupMenus();
     void setupConnections();
     void loadSettings();
-    void saveSettings();
-    void fetchWeather(const QString &city);
-    void fetchForecast(const QString &city);
-    void displayWeather(const WeatherData &data);
-    void displayForecast(const QList<ForecastData> &forecast);
+    void saveLastLocation();
+    void onFavoritesPageLoaded(const QList<StoredFavorite> &page, bool last);
+    void showCity(const QString &city);
+    void watchFavorite(const QString &city);
+    void fetchEnsemble(const GeoPoint &point);
+    void displayWeather(const WeatherResult &result);
+    void displayForecast(const QVector<ForecastData> &forecast);
     void applyTheme();
     void updateLanguage();
-    void updateFavoritesList();
-    QString getWeatherIconUrl(const QString &icon);
+    void recordObservation(const WeatherResult &result);
+    AlertSample alertSample(const WeatherResult &result) const;
     double convertTemp(double temp);
     double convertSpeed(double speed);
     QString getTempUnit();
     QString getSpeedUnit();
     QNetworkRequest createRequest(const QUrl &url);
     QString getWeatherDescription(int code);
-    QString getWeatherIcon(const QString &description);
+    QPixmap getWeatherIcon(int code, int size) const;
+    void redisplayWeather();
     QString getCurrentLanguageCode() const;
+    QString locationLabel(const QString &location) const;
 
     Ui::MainWindow *ui;
-    QNetworkAccessManager *m_networkManager;
+    WeatherService *m_service;
     QSettings *m_settings;
-    QTimer *m_refreshTimer;
     QTimer *m_searchDebounceTimer;
+    QMenu *m_viewMenu;
+    QAction *m_historyAction;
+    QAction *m_climateAction;
+    QAction *m_heatmapAction;
+    QAction *m_alertsAction;
+    QAction *m_ensembleAction;
+    QAction *m_nowcastAction;
+    QTimer *m_nowcastTimer;
+    QSystemTrayIcon *m_trayIcon;
 
     // Данные
     QString m_currentCity;
-    QStringList m_favoriteCities;
+    FavoritesModel *m_favoritesModel;
+    FavoritesDelegate *m_favoritesDelegate;
+    FavoritesStore *m_favoritesStore;
+    SuggestionPrefetcher *m_prefetcher;
+    ForecastDetailLoader *m_detailLoader;
+    RegionGrid *m_regionGrid;
+    NowcastFeed *m_nowcast;
+    NowcastChart *m_nowcastChart;
+    WeatherServer *m_server;
+    AlertEngine *m_alertEngine;
     QString m_currentLanguage;
     bool m_isCelsius;
-    QMap<QString, QPixmap> m_iconCache;
+    ThemeEngine::Theme m_theme;
+    bool m_screenTracked;
     QCompleter *m_completer;
     QStringListModel *m_completerModel;
-    QSet<QNetworkReply*> m_searchReplies;
+    RequestScheduler::Ticket m_suggestionTicket;
+
+    // Индекс городов для координат; разрешённые геокодером названия хранит сервис
+    CityIndex m_cityIndex;
+    GeoPoint m_currentPosition;
+    bool m_hasPosition;
+    bool m_startupLoadPending;
+
+    // История наблюдений по всем городам
+    ObservationHistory m_history;
 
-    // Сохраненные данные погоды для перерисовки
-    WeatherData m_currentWeatherData;
-    QList<ForecastData> m_currentForecastData;
-    bool m_hasWeatherData;
+    // Подписки на сервис и последний результат текущего города для перерисовки
+    WeatherService::Subscription m_citySubscription;
+    QHash<QString, WeatherService::Subscription> m_favoriteSubscriptions;
+    WeatherResult m_currentResult;
+    EnsembleSeries m_currentEnsemble;
+    QString m_ensembleCity;
+    qint64 m_ensembleFetchedAt;
+    bool m_ensembleMode;
+    bool m_nowcastMode;
+    QSet<qint64> m_expandedDays;
+    quint32 m_expandedLocation;
 
     // Константы
     const QString WEATHER_API_URL = "http://api.open-meteo.com/v1/forecast";
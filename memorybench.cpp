@@ -0,0 +1,211 @@
+#include "memorybench.h"
+#include "weatherrecords.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QVector>
+
+namespace {
+const int DAILY_POINTS = 5;
+const int HOURLY_POINTS = 24;
+
+// Раскладка записей до перехода на компактные типы
+struct LegacyWeatherData {
+    QString city;
+    QString country;
+    double temp;
+    double feelsLike;
+    int humidity;
+    double windSpeed;
+    QString description;
+    QString icon;
+    QDateTime dateTime;
+    int weatherCode;
+};
+
+struct LegacyForecastData {
+    QDateTime dateTime;
+    double temp;
+    double tempMin;
+    double tempMax;
+    QString description;
+    QString icon;
+    int weatherCode;
+};
+
+struct LegacyLocation {
+    LegacyWeatherData current;
+    QVector<LegacyForecastData> daily;
+    QVector<LegacyForecastData> hourly;
+};
+
+struct CompactLocation {
+    WeatherData current;
+    QVector<ForecastData> daily;
+    QVector<ForecastData> hourly;
+};
+
+// Описания, как раньше, создаются заново для каждой записи (TR возвращает новую строку)
+QString description(int code)
+{
+    static const char *names[] = { "Clear", "Cloudy", "Rain", "Snow", "Thunderstorm" };
+    return QString::fromLatin1(names[code % 5]);
+}
+
+qint64 stringBytes(const QString &s)
+{
+    // Заголовок QArrayData + символы с завершающим нулём
+    return s.isNull() ? 0 : qint64(sizeof(void*) * 3 + (s.capacity() + 1) * sizeof(QChar));
+}
+
+qint64 residentBytes()
+{
+#ifdef Q_OS_LINUX
+    QFile statm("/proc/self/statm");
+    if (statm.open(QIODevice::ReadOnly)) {
+        QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() > 1) {
+            return fields[1].toLongLong() * 4096;
+        }
+    }
+#endif
+    return -1;
+}
+
+LegacyForecastData legacyPoint(qint64 time, int code)
+{
+    LegacyForecastData fd;
+    fd.dateTime = QDateTime::fromSecsSinceEpoch(time);
+    fd.temp = 10.0;
+    fd.tempMin = 5.0;
+    fd.tempMax = 15.0;
+    fd.description = description(code);
+    fd.icon = QString::number(code);
+    fd.weatherCode = code;
+    return fd;
+}
+
+ForecastData compactPoint(qint64 time, int code)
+{
+    ForecastData fd;
+    fd.time = time;
+    fd.tempMin = 5.0f;
+    fd.tempMax = 15.0f;
+    fd.weatherCode = quint8(code);
+    return fd;
+}
+
+void runCompact(int count, QTextStream &out)
+{
+    qint64 rssBefore = residentBytes();
+    QElapsedTimer timer;
+    timer.start();
+
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    LocationTable table;
+    QVector<CompactLocation> locations(count);
+    for (int i = 0; i < count; ++i) {
+        CompactLocation &loc = locations[i];
+        loc.current.locationId = table.intern(QString("City %1, Country %2").arg(i).arg(i % 200));
+        loc.current.time = now;
+        loc.current.temp = 10.0f;
+        loc.current.feelsLike = 9.0f;
+        loc.current.windSpeed = 3.0f;
+        loc.current.humidity = 70;
+        loc.current.weatherCode = quint8(i % 100);
+
+        loc.daily.reserve(DAILY_POINTS);
+        for (int d = 0; d < DAILY_POINTS; ++d) {
+            loc.daily.append(compactPoint(now + d * 86400, i + d));
+        }
+        loc.hourly.reserve(HOURLY_POINTS);
+        for (int h = 0; h < HOURLY_POINTS; ++h) {
+            loc.hourly.append(compactPoint(now + h * 3600, i + h));
+        }
+    }
+
+    qint64 estimate = qint64(count) * (sizeof(CompactLocation)
+                                       + (DAILY_POINTS + HOURLY_POINTS) * sizeof(ForecastData));
+    for (int i = 0; i < table.size(); ++i) {
+        estimate += stringBytes(table.name(quint32(i)));
+    }
+
+    qint64 rssAfter = residentBytes();
+    out << "  compact: estimated " << estimate / 1024 << " KiB, "
+        << estimate / count << " B/location";
+    if (rssBefore >= 0) out << ", RSS +" << (rssAfter - rssBefore) / 1024 << " KiB";
+    out << ", build " << timer.elapsed() << " ms\n";
+    out.flush();
+}
+
+void runLegacy(int count, QTextStream &out)
+{
+    qint64 rssBefore = residentBytes();
+    QElapsedTimer timer;
+    timer.start();
+
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    QVector<LegacyLocation> locations(count);
+    qint64 estimate = qint64(count) * sizeof(LegacyLocation);
+    for (int i = 0; i < count; ++i) {
+        LegacyLocation &loc = locations[i];
+        loc.current.city = QString("City %1").arg(i);
+        loc.current.country = QString("Country %1").arg(i % 200);
+        loc.current.temp = 10.0;
+        loc.current.feelsLike = 9.0;
+        loc.current.humidity = 70;
+        loc.current.windSpeed = 3.0;
+        loc.current.weatherCode = i % 100;
+        loc.current.description = description(i);
+        loc.current.icon = QString::number(i % 100);
+        loc.current.dateTime = QDateTime::fromSecsSinceEpoch(now);
+
+        estimate += stringBytes(loc.current.city) + stringBytes(loc.current.country)
+                + stringBytes(loc.current.description) + stringBytes(loc.current.icon);
+
+        loc.daily.reserve(DAILY_POINTS);
+        for (int d = 0; d < DAILY_POINTS; ++d) {
+            loc.daily.append(legacyPoint(now + d * 86400, i + d));
+        }
+        loc.hourly.reserve(HOURLY_POINTS);
+        for (int h = 0; h < HOURLY_POINTS; ++h) {
+            loc.hourly.append(legacyPoint(now + h * 3600, i + h));
+        }
+
+        estimate += (DAILY_POINTS + HOURLY_POINTS) * qint64(sizeof(LegacyForecastData));
+        for (const LegacyForecastData &fd : loc.daily) {
+            estimate += stringBytes(fd.description) + stringBytes(fd.icon);
+        }
+        for (const LegacyForecastData &fd : loc.hourly) {
+            estimate += stringBytes(fd.description) + stringBytes(fd.icon);
+        }
+    }
+
+    // QDateTime вне короткого представления держит отдельный блок в куче - в оценку не входит
+    qint64 rssAfter = residentBytes();
+    out << "  legacy:  estimated " << estimate / 1024 << " KiB, "
+        << estimate / count << " B/location";
+    if (rssBefore >= 0) out << ", RSS +" << (rssAfter - rssBefore) / 1024 << " KiB";
+    out << ", build " << timer.elapsed() << " ms\n";
+    out.flush();
+}
+}
+
+int runMemoryBenchmark()
+{
+    QTextStream out(stdout);
+    out << "Record sizes: WeatherData " << sizeof(WeatherData)
+        << " B (legacy " << sizeof(LegacyWeatherData) << " B + strings), ForecastData "
+        << sizeof(ForecastData) << " B (legacy " << sizeof(LegacyForecastData) << " B + strings)\n";
+    out << "Per location: current + " << DAILY_POINTS << " daily + " << HOURLY_POINTS << " hourly points\n";
+
+    const int counts[] = { 1000, 10000 };
+    for (int count : counts) {
+        out << count << " locations:\n";
+        // Компактный вариант первым: освобождённая куча прежнего не искажает его RSS
+        runCompact(count, out);
+        runLegacy(count, out);
+    }
+    return 0;
+}
@@ -0,0 +1,8 @@
+#ifndef MEMORYBENCH_H
+#define MEMORYBENCH_H
+
+// Сравнение памяти под записи погоды: прежняя раскладка со строками и QDateTime
+// против компактных WeatherData/ForecastData. Запуск: SimpleWeather --bench-memory
+int runMemoryBenchmark();
+
+#endif // MEMORYBENCH_H
@@ -0,0 +1,319 @@
+#include "networkcapture.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+#include <QUrlQuery>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+NetworkCapture::Mode g_mode = NetworkCapture::Off;
+QString g_path;
+double g_speed = 1.0;
+
+QJsonArray headersToJson(const QList<QPair<QByteArray, QByteArray>> &headers)
+{
+    QJsonArray array;
+    for (const auto &header : headers) {
+        array.append(QJsonArray() << QString::fromLatin1(header.first) << QString::fromLatin1(header.second));
+    }
+    return array;
+}
+
+QList<QPair<QByteArray, QByteArray>> headersFromJson(const QJsonArray &array)
+{
+    QList<QPair<QByteArray, QByteArray>> headers;
+    for (const QJsonValue &value : array) {
+        QJsonArray pair = value.toArray();
+        if (pair.size() != 2) continue;
+        headers.append(qMakePair(pair[0].toString().toLatin1(), pair[1].toString().toLatin1()));
+    }
+    return headers;
+}
+
+QString operationName(QNetworkAccessManager::Operation op, const QNetworkRequest &request)
+{
+    switch (op) {
+    case QNetworkAccessManager::HeadOperation: return "HEAD";
+    case QNetworkAccessManager::GetOperation: return "GET";
+    case QNetworkAccessManager::PutOperation: return "PUT";
+    case QNetworkAccessManager::PostOperation: return "POST";
+    case QNetworkAccessManager::DeleteOperation: return "DELETE";
+    default: return QString::fromLatin1(request.attribute(QNetworkRequest::CustomVerbAttribute).toByteArray());
+    }
+}
+}
+
+void NetworkCapture::configure(Mode mode, const QString &path, double speed)
+{
+    g_mode = mode;
+    g_path = path;
+    g_speed = speed;
+}
+
+QNetworkAccessManager *NetworkCapture::createManager(QObject *parent)
+{
+    switch (g_mode) {
+    case Capture:
+        return new CaptureNetworkManager(g_path, parent);
+    case Replay:
+        // speed 2 - вдвое быстрее записи, 0 - без задержек
+        return new ReplayNetworkManager(g_path, g_speed > 0 ? 1.0 / g_speed : 0.0, parent);
+    default:
+        return new QNetworkAccessManager(parent);
+    }
+}
+
+QByteArray NetworkCapture::encode(const CapturedExchange &exchange)
+{
+    QJsonObject obj;
+    obj["method"] = exchange.method;
+    obj["url"] = exchange.url.toString();
+    obj["requestHeaders"] = headersToJson(exchange.requestHeaders);
+    obj["status"] = exchange.status;
+    obj["error"] = exchange.error;
+    obj["responseHeaders"] = headersToJson(exchange.responseHeaders);
+    obj["body"] = QString::fromLatin1(exchange.body.toBase64());
+    obj["startedMs"] = double(exchange.startedMs);
+    obj["durationMs"] = double(exchange.durationMs);
+    return QJsonDocument(obj).toJson(QJsonDocument::Compact);
+}
+
+bool NetworkCapture::decode(const QByteArray &line, CapturedExchange *exchange)
+{
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) return false;
+
+    QJsonObject obj = doc.object();
+    exchange->method = obj["method"].toString();
+    exchange->url = QUrl(obj["url"].toString());
+    exchange->requestHeaders = headersFromJson(obj["requestHeaders"].toArray());
+    exchange->status = obj["status"].toInt();
+    exchange->error = obj["error"].toInt();
+    exchange->responseHeaders = headersFromJson(obj["responseHeaders"].toArray());
+    exchange->body = QByteArray::fromBase64(obj["body"].toString().toLatin1());
+    exchange->startedMs = qint64(obj["startedMs"].toDouble());
+    exchange->durationMs = qint64(obj["durationMs"].toDouble());
+    return exchange->url.isValid();
+}
+
+QString NetworkCapture::matchKey(const QString &method, const QUrl &url)
+{
+    // Даты архива и почасовой детализации меняются день ото дня - для сопоставления не важны
+    QList<QPair<QString, QString>> items = QUrlQuery(url).queryItems();
+    for (auto &item : items) {
+        if (item.first == "start_date" || item.first == "end_date") {
+            item.second.clear();
+        }
+    }
+    std::sort(items.begin(), items.end());
+
+    QUrlQuery sorted;
+    sorted.setQueryItems(items);
+    return method + ' ' + url.host() + url.path() + '?' + sorted.toString();
+}
+
+CaptureNetworkManager::CaptureNetworkManager(const QString &path, QObject *parent)
+    : QNetworkAccessManager(parent)
+    , m_file(path)
+    , m_recorded(0)
+{
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Capture file not writable:" << path << m_file.errorString();
+    }
+    m_clock.start();
+    qDebug() << "Capturing network traffic to" << path;
+}
+
+CaptureNetworkManager::~CaptureNetworkManager()
+{
+    qDebug() << "Capture finished, exchanges recorded:" << m_recorded;
+}
+
+QNetworkReply *CaptureNetworkManager::createRequest(Operation op, const QNetworkRequest &request,
+                                                    QIODevice *outgoingData)
+{
+    QNetworkReply *reply = QNetworkAccessManager::createRequest(op, request, outgoingData);
+    qint64 startedMs = m_clock.elapsed();
+
+    // Подключаемся раньше владельцев ответа: тело ещё никто не прочитал
+    connect(reply, &QNetworkReply::finished, this, [this, reply, request, startedMs]() {
+        record(reply, request, startedMs);
+    });
+    return reply;
+}
+
+void CaptureNetworkManager::record(QNetworkReply *reply, const QNetworkRequest &request, qint64 startedMs)
+{
+    if (!m_file.isOpen()) return;
+
+    CapturedExchange exchange;
+    exchange.method = operationName(reply->operation(), request);
+    exchange.url = reply->url();
+    for (const QByteArray &name : request.rawHeaderList()) {
+        exchange.requestHeaders.append(qMakePair(name, request.rawHeader(name)));
+    }
+    exchange.status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    exchange.error = int(reply->error());
+    exchange.responseHeaders = reply->rawHeaderPairs();
+    // peek не сдвигает позицию чтения: владелец ответа получит тело целиком
+    exchange.body = reply->peek(reply->bytesAvailable());
+    exchange.startedMs = startedMs;
+    exchange.durationMs = m_clock.elapsed() - startedMs;
+
+    m_file.write(NetworkCapture::encode(exchange) + '\n');
+    m_file.flush();
+    m_recorded++;
+}
+
+ReplayNetworkManager::ReplayNetworkManager(const QString &path, double scale, QObject *parent)
+    : QNetworkAccessManager(parent)
+    , m_scale(scale)
+    , m_served(0)
+    , m_missed(0)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Capture file not readable:" << path << file.errorString();
+        return;
+    }
+
+    int count = 0;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty()) continue;
+
+        CapturedExchange exchange;
+        if (!NetworkCapture::decode(line, &exchange)) {
+            qWarning() << "Skipping malformed capture line" << count + 1;
+            continue;
+        }
+
+        Queue &queue = m_exchanges[NetworkCapture::matchKey(exchange.method, exchange.url)];
+        queue.next = 0;
+        queue.exchanges.append(exchange);
+        count++;
+    }
+
+    qDebug() << "Replaying" << count << "exchanges from" << path << "time scale:" << m_scale;
+}
+
+ReplayNetworkManager::~ReplayNetworkManager()
+{
+    qDebug() << "Replay finished, served:" << m_served << "missed:" << m_missed;
+}
+
+QNetworkReply *ReplayNetworkManager::createRequest(Operation op, const QNetworkRequest &request,
+                                                   QIODevice *outgoingData)
+{
+    Q_UNUSED(outgoingData)
+
+    auto it = m_exchanges.find(NetworkCapture::matchKey(operationName(op, request), request.url()));
+    if (it == m_exchanges.end()) {
+        m_missed++;
+        qDebug() << "Replay miss:" << request.url().toString();
+        return new ReplayReply(request, op, nullptr, 0, this);
+    }
+
+    Queue &queue = it.value();
+    const CapturedExchange &exchange = queue.exchanges[queue.next];
+    if (queue.next + 1 < queue.exchanges.size()) {
+        queue.next++;
+    }
+    m_served++;
+
+    return new ReplayReply(request, op, &exchange, qint64(exchange.durationMs * m_scale), this);
+}
+
+ReplayReply::ReplayReply(const QNetworkRequest &request, QNetworkAccessManager::Operation op,
+                         const CapturedExchange *exchange, qint64 delayMs, QObject *parent)
+    : QNetworkReply(parent)
+    , m_offset(0)
+    , m_found(exchange != nullptr)
+    , m_delivered(false)
+{
+    setRequest(request);
+    setUrl(request.url());
+    setOperation(op);
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+    if (exchange) {
+        m_exchange = *exchange;
+    }
+
+    // Как у настоящего ответа: сигналы приходят после возврата из get()
+    QTimer::singleShot(delayMs, this, &ReplayReply::deliver);
+}
+
+void ReplayReply::deliver()
+{
+    if (isFinished()) return;
+    m_delivered = true;
+
+    NetworkError code = NoError;
+    if (!m_found) {
+        code = ContentNotFoundError;
+        setError(code, "Not in capture: " + url().toString());
+    } else {
+        setAttribute(QNetworkRequest::HttpStatusCodeAttribute, m_exchange.status);
+        for (const auto &header : m_exchange.responseHeaders) {
+            setRawHeader(header.first, header.second);
+        }
+        code = NetworkError(m_exchange.error);
+        if (code != NoError) {
+            setError(code, "Replayed error");
+        }
+        emit metaDataChanged();
+        if (!m_exchange.body.isEmpty()) {
+            emit readyRead();
+            emit downloadProgress(m_exchange.body.size(), m_exchange.body.size());
+        }
+    }
+
+    if (code != NoError) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+        emit errorOccurred(code);
+#else
+        emit error(code);
+#endif
+    }
+
+    setFinished(true);
+    emit finished();
+}
+
+void ReplayReply::abort()
+{
+    if (isFinished()) return;
+
+    setError(OperationCanceledError, "Operation canceled");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    emit errorOccurred(OperationCanceledError);
+#else
+    emit error(OperationCanceledError);
+#endif
+    setFinished(true);
+    emit finished();
+}
+
+qint64 ReplayReply::bytesAvailable() const
+{
+    qint64 pending = m_delivered ? m_exchange.body.size() - m_offset : 0;
+    return pending + QNetworkReply::bytesAvailable();
+}
+
+qint64 ReplayReply::readData(char *data, qint64 maxSize)
+{
+    // До доставки тело ещё "в пути"
+    if (!m_delivered) return 0;
+
+    qint64 count = qMin(maxSize, qint64(m_exchange.body.size()) - m_offset);
+    if (count <= 0) return -1;
+
+    memcpy(data, m_exchange.body.constData() + m_offset, size_t(count));
+    m_offset += count;
+    return count;
+}
@@ -0,0 +1,119 @@
+#ifndef NETWORKCAPTURE_H
+#define NETWORKCAPTURE_H
+
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QVector>
+
+// Один обмен с сервером: запрос, ответ и время от отправки до конца ответа
+struct CapturedExchange {
+    QString method;
+    QUrl url;
+    QList<QPair<QByteArray, QByteArray>> requestHeaders;
+    int status;
+    int error; // QNetworkReply::NetworkError
+    QList<QPair<QByteArray, QByteArray>> responseHeaders;
+    QByteArray body;
+    qint64 startedMs; // от начала записи
+    qint64 durationMs;
+};
+
+// Запись и воспроизведение сетевых сессий для повторяемых замеров.
+// Формат файла - JSON по строке на обмен, тело ответа в base64.
+class NetworkCapture
+{
+public:
+    enum Mode {
+        Off,
+        Capture,
+        Replay
+    };
+
+    // Вызывается из main() до создания окна
+    static void configure(Mode mode, const QString &path, double speed = 1.0);
+    // Менеджер для MainWindow: обычный, записывающий или воспроизводящий
+    static QNetworkAccessManager *createManager(QObject *parent);
+
+    static QByteArray encode(const CapturedExchange &exchange);
+    static bool decode(const QByteArray &line, CapturedExchange *exchange);
+    // Ключ сопоставления: хост, путь и отсортированные параметры без дат диапазона
+    static QString matchKey(const QString &method, const QUrl &url);
+};
+
+// Пропускает запросы в сеть и дописывает каждый завершённый обмен в файл
+class CaptureNetworkManager : public QNetworkAccessManager
+{
+    Q_OBJECT
+
+public:
+    CaptureNetworkManager(const QString &path, QObject *parent = nullptr);
+    ~CaptureNetworkManager();
+
+protected:
+    QNetworkReply *createRequest(Operation op, const QNetworkRequest &request,
+                                 QIODevice *outgoingData = nullptr) override;
+
+private:
+    void record(QNetworkReply *reply, const QNetworkRequest &request, qint64 startedMs);
+
+    QFile m_file;
+    QElapsedTimer m_clock;
+    int m_recorded;
+};
+
+// Отдаёт записанные ответы без сети; время ответа - записанное, умноженное на scale
+class ReplayNetworkManager : public QNetworkAccessManager
+{
+    Q_OBJECT
+
+public:
+    ReplayNetworkManager(const QString &path, double scale, QObject *parent = nullptr);
+    ~ReplayNetworkManager();
+
+protected:
+    QNetworkReply *createRequest(Operation op, const QNetworkRequest &request,
+                                 QIODevice *outgoingData = nullptr) override;
+
+private:
+    // Повторы одного запроса отдаются по очереди, последний ответ - для всех следующих
+    struct Queue {
+        QVector<CapturedExchange> exchanges;
+        int next;
+    };
+
+    QHash<QString, Queue> m_exchanges;
+    double m_scale;
+    int m_served;
+    int m_missed;
+};
+
+class ReplayReply : public QNetworkReply
+{
+    Q_OBJECT
+
+public:
+    ReplayReply(const QNetworkRequest &request, QNetworkAccessManager::Operation op,
+                const CapturedExchange *exchange, qint64 delayMs, QObject *parent = nullptr);
+
+    void abort() override;
+    qint64 bytesAvailable() const override;
+    bool isSequential() const override { return true; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+
+private:
+    void deliver();
+
+    CapturedExchange m_exchange;
+    qint64 m_offset;
+    bool m_found;
+    bool m_delivered;
+};
+
+#endif // NETWORKCAPTURE_H
@@ -0,0 +1,259 @@
+#include "nowcast.h"
+#include <QNetworkReply>
+#include <QUrlQuery>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDateTime>
+#include <QtMath>
+#include <QDebug>
+
+namespace {
+const int PAST_SLOTS = 4;          // час истории на графике
+const int HORIZON_SLOTS = 24;      // 6 часов вперёд
+const int REVISION_SLOTS = 4;      // ближайший час перезапрашивается каждый раз
+const qint64 FULL_SYNC_MS = 60 * 60 * 1000;
+
+bool sameValue(float a, float b)
+{
+    return (qIsNaN(a) && qIsNaN(b)) || a == b;
+}
+
+QString localStamp(qint64 time)
+{
+    // Время хранится как местное, записанное в UTC - так его и ждёт API
+    return QDateTime::fromSecsSinceEpoch(time, Qt::UTC).toString("yyyy-MM-ddTHH:mm");
+}
+}
+
+NowcastBuffer::NowcastBuffer(int capacity)
+{
+    m_slots.resize(qMax(capacity, 1));
+    clear();
+}
+
+void NowcastBuffer::clear()
+{
+    NowcastSlot empty;
+    empty.time = -1;
+    empty.precipitation = float(qQNaN());
+    empty.windSpeed = float(qQNaN());
+    m_slots.fill(empty);
+    m_first = 0;
+    m_last = -SLOT_SECONDS;
+}
+
+int NowcastBuffer::indexFor(qint64 time) const
+{
+    qint64 index = (time / SLOT_SECONDS) % m_slots.size();
+    return int(index < 0 ? index + m_slots.size() : index);
+}
+
+bool NowcastBuffer::slot(qint64 time, NowcastSlot *out) const
+{
+    if (isEmpty() || time < m_first || time > m_last) return false;
+
+    const NowcastSlot &stored = m_slots[indexFor(time)];
+    if (stored.time != time) return false;
+    *out = stored;
+    return true;
+}
+
+bool NowcastBuffer::merge(const QVector<NowcastSlot> &slots, qint64 *changedFrom, qint64 *changedTo)
+{
+    const qint64 span = (m_slots.size() - 1) * SLOT_SECONDS;
+    bool changed = false;
+
+    for (const NowcastSlot &incoming : slots) {
+        qint64 time = align(incoming.time);
+
+        if (isEmpty()) {
+            m_first = m_last = time;
+        } else if (time > m_last) {
+            m_last = time;
+            // Окно ушло вперёд: слоты старше ёмкости буфера вытесняются
+            if (m_last - m_first > span) {
+                m_first = m_last - span;
+            }
+        } else if (time < m_first) {
+            if (m_last - time > span) continue;
+            m_first = time;
+        }
+
+        NowcastSlot &stored = m_slots[indexFor(time)];
+        if (stored.time == time && sameValue(stored.precipitation, incoming.precipitation)
+                && sameValue(stored.windSpeed, incoming.windSpeed)) {
+            continue;
+        }
+
+        stored.time = time;
+        stored.precipitation = incoming.precipitation;
+        stored.windSpeed = incoming.windSpeed;
+
+        if (!changed) {
+            *changedFrom = *changedTo = time;
+            changed = true;
+        } else {
+            *changedFrom = qMin(*changedFrom, time);
+            *changedTo = qMax(*changedTo, time);
+        }
+    }
+    return changed;
+}
+
+void NowcastBuffer::dropBefore(qint64 time)
+{
+    if (isEmpty() || time <= m_first) return;
+    if (time > m_last) {
+        clear();
+        return;
+    }
+    m_first = align(time);
+}
+
+NowcastFeed::NowcastFeed(RequestScheduler *scheduler, const QString &apiUrl, QObject *parent)
+    : QObject(parent)
+    , m_scheduler(scheduler)
+    , m_apiUrl(apiUrl)
+    , m_locationId(0xffffffffu)
+    , m_point()
+    , m_ticket(0)
+    , m_utcOffset(0)
+    , m_hasOffset(false)
+    , m_lastFullSync(0)
+    , m_revisionPending(false)
+{
+}
+
+bool NowcastFeed::setLocation(quint32 locationId, const GeoPoint &point)
+{
+    m_point = point;
+    if (locationId == m_locationId) return false;
+
+    if (m_ticket) {
+        m_scheduler->cancel(m_ticket);
+        m_ticket = 0;
+    }
+    m_locationId = locationId;
+    m_buffer.clear();
+    m_hasOffset = false;
+    m_lastFullSync = 0;
+    m_revisionPending = false;
+    return true;
+}
+
+qint64 NowcastFeed::localNow() const
+{
+    return QDateTime::currentSecsSinceEpoch() + m_utcOffset;
+}
+
+void NowcastFeed::refresh()
+{
+    if (m_ticket || m_locationId == 0xffffffffu) return;
+
+    qint64 nowSlot = NowcastBuffer::align(localNow());
+    qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+
+    // Ушедшие в прошлое слоты освобождают место в кольце
+    qint64 first = m_buffer.firstTime();
+    m_buffer.dropBefore(nowSlot - PAST_SLOTS * NowcastBuffer::SLOT_SECONDS);
+    if (m_buffer.firstTime() != first || m_buffer.isEmpty()) {
+        emit updated(m_buffer.firstTime(), m_buffer.firstTime());
+    }
+
+    bool full = !m_hasOffset || m_buffer.isEmpty() || nowMs - m_lastFullSync > FULL_SYNC_MS;
+    if (full) {
+        m_revisionPending = false;
+        send(true, 0, 0);
+        return;
+    }
+
+    // Новое окно после последнего слота с перекрытием на последние слоты буфера
+    qint64 start = qMax(nowSlot, m_buffer.lastTime() - (REVISION_SLOTS - 1) * NowcastBuffer::SLOT_SECONDS);
+    qint64 end = nowSlot + HORIZON_SLOTS * NowcastBuffer::SLOT_SECONDS;
+    // Ближайший час в это окно обычно не попадает - за ним уйдёт отдельный короткий запрос
+    m_revisionPending = start > nowSlot;
+    send(false, start, end);
+}
+
+void NowcastFeed::send(bool full, qint64 start, qint64 end)
+{
+    QUrl url(m_apiUrl);
+    QUrlQuery query;
+    query.addQueryItem("latitude", QString::number(m_point.lat));
+    query.addQueryItem("longitude", QString::number(m_point.lon));
+    query.addQueryItem("minutely_15", "precipitation,wind_speed_10m");
+    query.addQueryItem("timezone", "auto");
+    query.addQueryItem("timeformat", "unixtime");
+
+    if (full) {
+        query.addQueryItem("past_minutely_15", QString::number(PAST_SLOTS));
+        query.addQueryItem("forecast_minutely_15", QString::number(HORIZON_SLOTS));
+    } else {
+        query.addQueryItem("start_minutely_15", localStamp(start));
+        query.addQueryItem("end_minutely_15", localStamp(end));
+    }
+    url.setQuery(query);
+
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::UserAgentHeader, "SimpleWeather/1.0");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    request.setTransferTimeout(10000);
+#endif
+
+    m_ticket = m_scheduler->get(request, RequestScheduler::CurrentCity, QString::number(m_locationId), this,
+                                [this, full](QNetworkReply *reply) {
+        onReplyFinished(reply, full);
+    });
+}
+
+void NowcastFeed::onReplyFinished(QNetworkReply *reply, bool full)
+{
+    m_ticket = 0;
+
+    if (reply->error() != QNetworkReply::NoError) {
+        qDebug() << "Nowcast error:" << reply->errorString();
+        m_revisionPending = false;
+        return;
+    }
+
+    QByteArray body = reply->readAll();
+    QJsonObject obj = QJsonDocument::fromJson(body).object();
+    m_utcOffset = qint64(obj["utc_offset_seconds"].toDouble());
+    m_hasOffset = true;
+    if (full) {
+        m_lastFullSync = QDateTime::currentMSecsSinceEpoch();
+    }
+
+    const QJsonObject minutely = obj["minutely_15"].toObject();
+    const QJsonArray times = minutely["time"].toArray();
+    const QJsonArray precipitation = minutely["precipitation"].toArray();
+    const QJsonArray wind = minutely["wind_speed_10m"].toArray();
+
+    QVector<NowcastSlot> slots;
+    slots.reserve(times.size());
+    for (int i = 0; i < times.size(); ++i) {
+        NowcastSlot slot;
+        slot.time = qint64(times[i].toDouble()) + m_utcOffset;
+        slot.precipitation = precipitation[i].isDouble() ? float(precipitation[i].toDouble()) : float(qQNaN());
+        slot.windSpeed = wind[i].isDouble() ? float(wind[i].toDouble()) : float(qQNaN());
+        slots.append(slot);
+    }
+
+    qint64 from = 0;
+    qint64 to = 0;
+    bool changed = m_buffer.merge(slots, &from, &to);
+
+    qDebug() << "Nowcast" << (full ? "full" : "incremental") << "slots:" << slots.size()
+             << "bytes:" << body.size() << "changed:" << (changed ? (to - from) / NowcastBuffer::SLOT_SECONDS + 1 : 0);
+
+    if (changed) {
+        emit updated(from, to);
+    }
+
+    if (m_revisionPending) {
+        m_revisionPending = false;
+        qint64 nowSlot = NowcastBuffer::align(localNow());
+        send(false, nowSlot, nowSlot + (REVISION_SLOTS - 1) * NowcastBuffer::SLOT_SECONDS);
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef NOWCAST_H
+#define NOWCAST_H
+
+#include <QObject>
+#include <QVector>
+#include "cityindex.h"
+#include "requestscheduler.h"
+
+class QNetworkReply;
+
+// Слот 15-минутного прогноза. time - местное время, записанное как UTC
+struct NowcastSlot {
+    qint64 time;
+    float precipitation; // мм за 15 минут
+    float windSpeed;
+};
+
+// Кольцевой буфер слотов с индексом по времени: новые слоты вытесняют самые старые,
+// пересмотренные значения заменяются на месте
+class NowcastBuffer
+{
+public:
+    static const qint64 SLOT_SECONDS = 900;
+
+    explicit NowcastBuffer(int capacity = 64);
+
+    void clear();
+    bool isEmpty() const { return m_last < m_first; }
+    int capacity() const { return m_slots.size(); }
+    qint64 firstTime() const { return m_first; }
+    qint64 lastTime() const { return m_last; }
+
+    bool slot(qint64 time, NowcastSlot *out) const;
+
+    // Возвращает true и диапазон времён, если какие-то значения изменились
+    bool merge(const QVector<NowcastSlot> &slots, qint64 *changedFrom, qint64 *changedTo);
+    void dropBefore(qint64 time);
+
+    static qint64 align(qint64 time) { return time - ((time % SLOT_SECONDS) + SLOT_SECONDS) % SLOT_SECONDS; }
+
+private:
+    int indexFor(qint64 time) const;
+
+    QVector<NowcastSlot> m_slots;
+    qint64 m_first;
+    qint64 m_last;
+};
+
+// Частое обновление 15-минутного прогноза осадков и ветра: запрашивается только
+// окно после последнего слота с небольшим перекрытием, следом - короткий запрос
+// ближайшего часа на пересмотры; полная сверка - раз в час, когда модель пересчитывается
+class NowcastFeed : public QObject
+{
+    Q_OBJECT
+
+public:
+    NowcastFeed(RequestScheduler *scheduler, const QString &apiUrl, QObject *parent = nullptr);
+
+    // true - место сменилось, буфер сброшен
+    bool setLocation(quint32 locationId, const GeoPoint &point);
+    void refresh();
+
+    const NowcastBuffer &buffer() const { return m_buffer; }
+    // Текущее время в той же шкале, что и слоты
+    qint64 localNow() const;
+
+signals:
+    void updated(qint64 from, qint64 to);
+
+private:
+    void send(bool full, qint64 start, qint64 end);
+    void onReplyFinished(QNetworkReply *reply, bool full);
+
+    RequestScheduler *m_scheduler;
+    QString m_apiUrl;
+    quint32 m_locationId;
+    GeoPoint m_point;
+
+    NowcastBuffer m_buffer;
+    RequestScheduler::Ticket m_ticket;
+    qint64 m_utcOffset;
+    bool m_hasOffset;
+    qint64 m_lastFullSync;
+    // После окна хвоста нужно перезапросить ближайший час
+    bool m_revisionPending;
+};
+
+#endif // NOWCAST_H
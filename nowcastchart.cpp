@@ -0,0 +1,160 @@
+#include "nowcastchart.h"
+#include "translator.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QDateTime>
+#include <QtMath>
+
+namespace {
+const int VISIBLE_SLOTS = 29;         // час истории и 6 часов вперёд
+const float PRECIP_MAX = 2.0f;        // мм за 15 минут - выше обрезается
+const float WIND_MAX = 20.0f;         // м/с
+const int LEFT_MARGIN = 36;
+const int RIGHT_MARGIN = 36;
+const int TOP_MARGIN = 18;
+const int BOTTOM_MARGIN = 18;
+}
+
+NowcastChart::NowcastChart(const NowcastBuffer *buffer, QWidget *parent)
+    : QWidget(parent)
+    , m_buffer(buffer)
+    , m_origin(-1)
+    , m_nowSlot(-1)
+    , m_isCelsius(true)
+{
+    setMinimumHeight(140);
+}
+
+void NowcastChart::setBuffer(const NowcastBuffer *buffer)
+{
+    m_buffer = buffer;
+    m_origin = -1;
+    update();
+}
+
+void NowcastChart::setCelsius(bool celsius)
+{
+    if (m_isCelsius == celsius) return;
+    m_isCelsius = celsius;
+    update();
+}
+
+QRect NowcastChart::plotRect() const
+{
+    return rect().adjusted(LEFT_MARGIN, TOP_MARGIN, -RIGHT_MARGIN, -BOTTOM_MARGIN);
+}
+
+int NowcastChart::slotWidth() const
+{
+    return qMax(1, plotRect().width() / VISIBLE_SLOTS);
+}
+
+int NowcastChart::xFor(qint64 time) const
+{
+    return plotRect().left() + int((time - m_origin) / NowcastBuffer::SLOT_SECONDS) * slotWidth();
+}
+
+void NowcastChart::updateRange(qint64 from, qint64 to, qint64 now)
+{
+    if (!m_buffer) return;
+
+    qint64 origin = m_buffer->isEmpty() ? -1 : m_buffer->firstTime();
+    qint64 nowSlot = NowcastBuffer::align(now);
+
+    // Сдвиг начала окна или отметки "сейчас" меняет положение всех столбиков
+    if (origin != m_origin || nowSlot != m_nowSlot) {
+        m_origin = origin;
+        m_nowSlot = nowSlot;
+        update();
+        return;
+    }
+
+    // Линия ветра соединяет соседние слоты - захватываем по слоту с каждой стороны
+    int width = slotWidth();
+    int left = xFor(from) - width;
+    int right = xFor(to) + 2 * width;
+    update(QRect(left, 0, right - left, height()));
+}
+
+void NowcastChart::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    painter.setClipRect(event->rect());
+    painter.fillRect(event->rect(), palette().color(QPalette::AlternateBase));
+    painter.setPen(palette().color(QPalette::Text));
+
+    if (!m_buffer || m_buffer->isEmpty()) {
+        painter.drawText(rect(), Qt::AlignCenter, TR("Nowcast/no_data"));
+        return;
+    }
+
+    const QRect plot = plotRect();
+    const int width = slotWidth();
+    const float windScale = m_isCelsius ? 1.0f : 2.237f;
+
+    // Подписи шкал меняются только при полной перерисовке
+    if (event->rect().left() < plot.left()) {
+        painter.drawText(QRect(0, 0, LEFT_MARGIN + 40, TOP_MARGIN), Qt::AlignLeft | Qt::AlignTop,
+                         TR("Nowcast/precipitation"));
+        painter.drawText(QRect(0, plot.top(), LEFT_MARGIN - 4, 16), Qt::AlignRight | Qt::AlignTop,
+                         QString::number(PRECIP_MAX, 'f', 0));
+        painter.drawText(QRect(0, plot.bottom() - 16, LEFT_MARGIN - 4, 16), Qt::AlignRight | Qt::AlignBottom, "0");
+    }
+    if (event->rect().right() > plot.right()) {
+        QString unit = m_isCelsius ? TR("Weather/speed_ms") : TR("Weather/speed_mph");
+        painter.drawText(QRect(plot.right() - 80, 0, 80 + RIGHT_MARGIN, TOP_MARGIN), Qt::AlignRight | Qt::AlignTop,
+                         TR("Nowcast/wind").arg(unit));
+        painter.drawText(QRect(plot.right() + 4, plot.top(), RIGHT_MARGIN - 4, 16), Qt::AlignLeft | Qt::AlignTop,
+                         QString::number(WIND_MAX * windScale, 'f', 0));
+    }
+
+    // Рисуем только слоты, попавшие в перерисовываемую область
+    int first = qMax(0, (event->rect().left() - plot.left()) / width - 1);
+    int last = qMin(VISIBLE_SLOTS - 1, (event->rect().right() - plot.left()) / width + 1);
+
+    QColor barColor = palette().color(QPalette::Highlight);
+    QPen windPen(palette().color(QPalette::Text), 2);
+    QPointF previous;
+    bool hasPrevious = false;
+
+    for (int i = first; i <= last; ++i) {
+        qint64 time = m_origin + i * NowcastBuffer::SLOT_SECONDS;
+        int x = plot.left() + i * width;
+
+        if (time % 3600 == 0) {
+            painter.setPen(palette().color(QPalette::Mid));
+            painter.drawLine(x, plot.top(), x, plot.bottom());
+            painter.setPen(palette().color(QPalette::Text));
+            painter.drawText(QRect(x - 30, plot.bottom() + 2, 60, BOTTOM_MARGIN - 2), Qt::AlignCenter,
+                             QDateTime::fromSecsSinceEpoch(time, Qt::UTC).toString("HH:mm"));
+        }
+
+        if (time == m_nowSlot) {
+            painter.fillRect(QRect(x, plot.top(), width, plot.height()), palette().color(QPalette::Mid).lighter(140));
+        }
+
+        NowcastSlot slot;
+        if (!m_buffer->slot(time, &slot)) {
+            hasPrevious = false;
+            continue;
+        }
+
+        if (!qIsNaN(slot.precipitation) && slot.precipitation > 0) {
+            int barHeight = int(qMin(slot.precipitation / PRECIP_MAX, 1.0f) * plot.height());
+            painter.fillRect(QRect(x + 1, plot.bottom() - barHeight, width - 2, barHeight), barColor);
+        }
+
+        if (qIsNaN(slot.windSpeed)) {
+            hasPrevious = false;
+            continue;
+        }
+        QPointF point(x + width / 2.0,
+                      plot.bottom() - qMin(slot.windSpeed / WIND_MAX, 1.0f) * plot.height());
+        if (hasPrevious) {
+            painter.setPen(windPen);
+            painter.drawLine(previous, point);
+        }
+        previous = point;
+        hasPrevious = true;
+    }
+}
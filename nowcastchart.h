@@ -0,0 +1,38 @@
+#ifndef NOWCASTCHART_H
+#define NOWCASTCHART_H
+
+#include <QWidget>
+#include "nowcast.h"
+
+// График 15-минутного прогноза: столбики осадков и линия ветра.
+// Шкалы фиксированные, поэтому при обновлении перерисовывается только
+// изменившийся участок, а не весь график
+class NowcastChart : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit NowcastChart(const NowcastBuffer *buffer, QWidget *parent = nullptr);
+
+    // Буфер появляется вместе с лентой прогноза, до этого график пуст
+    void setBuffer(const NowcastBuffer *buffer);
+    void setCelsius(bool celsius);
+
+public slots:
+    void updateRange(qint64 from, qint64 to, qint64 now);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    QRect plotRect() const;
+    int slotWidth() const;
+    int xFor(qint64 time) const;
+
+    const NowcastBuffer *m_buffer;
+    qint64 m_origin;
+    qint64 m_nowSlot;
+    bool m_isCelsius;
+};
+
+#endif // NOWCASTCHART_H
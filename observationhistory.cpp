@@ -0,0 +1,277 @@
+#include "observationhistory.h"
+#include <QTextStream>
+#include <QtMath>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+const quint32 BLOCK_MAGIC = 0x53574842; // "SWHB"
+const int BLOCK_RECORDS = 256;
+
+// Заголовок блока: magic, locationId, count, reserved, firstTs, lastTs
+const int HEADER_SIZE = 32;
+const int COUNT_OFFSET = 8;
+const int LAST_TS_OFFSET = 24;
+
+// Столбцы идут подряд, каждый на BLOCK_RECORDS значений
+const int TS_OFFSET = HEADER_SIZE;
+const int TEMP_OFFSET = TS_OFFSET + BLOCK_RECORDS * 8;
+const int FEELS_OFFSET = TEMP_OFFSET + BLOCK_RECORDS * 4;
+const int HUMIDITY_OFFSET = FEELS_OFFSET + BLOCK_RECORDS * 4;
+const int WIND_OFFSET = HUMIDITY_OFFSET + BLOCK_RECORDS * 4;
+const int CODE_OFFSET = WIND_OFFSET + BLOCK_RECORDS * 4;
+const int BLOCK_SIZE = CODE_OFFSET + BLOCK_RECORDS;
+}
+
+ObservationHistory::ObservationHistory()
+    : m_map(nullptr)
+    , m_mappedSize(0)
+{
+}
+
+ObservationHistory::~ObservationHistory()
+{
+    unmap();
+}
+
+bool ObservationHistory::open(const QString &directory)
+{
+    m_locationsFile.setFileName(directory + "/history.locations");
+    if (!m_locationsFile.open(QIODevice::ReadWrite | QIODevice::Text)) {
+        qWarning() << "Failed to open history locations:" << m_locationsFile.errorString();
+        return false;
+    }
+
+    QTextStream in(&m_locationsFile);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    in.setCodec("UTF-8");
+#endif
+    while (!in.atEnd()) {
+        QString name = in.readLine();
+        m_locationIds.insert(name, m_locations.size());
+        m_locations.append(name);
+    }
+
+    m_dataFile.setFileName(directory + "/history.dat");
+    if (!m_dataFile.open(QIODevice::ReadWrite)) {
+        qWarning() << "Failed to open history data:" << m_dataFile.errorString();
+        return false;
+    }
+
+    buildIndex();
+    return true;
+}
+
+void ObservationHistory::buildIndex()
+{
+    m_blocks.clear();
+    if (!ensureMapped()) return;
+
+    // Читаются только заголовки блоков, столбцы не трогаем
+    qint64 blockCount = m_mappedSize / BLOCK_SIZE;
+    for (qint64 i = 0; i < blockCount; ++i) {
+        const uchar *header = m_map + i * BLOCK_SIZE;
+        quint32 magic, location, count;
+        qint64 firstTs, lastTs;
+        memcpy(&magic, header, 4);
+        memcpy(&location, header + 4, 4);
+        memcpy(&count, header + COUNT_OFFSET, 4);
+        memcpy(&firstTs, header + 16, 8);
+        memcpy(&lastTs, header + LAST_TS_OFFSET, 8);
+
+        if (magic != BLOCK_MAGIC || count > quint32(BLOCK_RECORDS)) {
+            qWarning() << "History block" << i << "is corrupted, skipping";
+            continue;
+        }
+
+        BlockRef ref;
+        ref.offset = i * BLOCK_SIZE;
+        ref.firstTs = firstTs;
+        ref.lastTs = lastTs;
+        ref.count = count;
+        m_blocks[location].append(ref);
+    }
+
+    qDebug() << "History index built, blocks:" << blockCount << "locations:" << m_blocks.size();
+}
+
+quint32 ObservationHistory::locationId(const QString &location, bool create)
+{
+    auto it = m_locationIds.constFind(location);
+    if (it != m_locationIds.constEnd()) return it.value();
+    if (!create) return quint32(-1);
+
+    quint32 id = m_locations.size();
+    m_locations.append(location);
+    m_locationIds.insert(location, id);
+
+    m_locationsFile.seek(m_locationsFile.size());
+    m_locationsFile.write(location.toUtf8() + "\n");
+    m_locationsFile.flush();
+    return id;
+}
+
+bool ObservationHistory::append(const QString &location, const HistoryRecord &record)
+{
+    if (!m_dataFile.isOpen()) return false;
+
+    quint32 id = locationId(location, true);
+    QVector<BlockRef> &blocks = m_blocks[id];
+
+    // Повторный ответ с тем же временем наблюдения не пишем
+    if (!blocks.isEmpty() && record.timestamp <= blocks.last().lastTs) {
+        return false;
+    }
+
+    if (blocks.isEmpty() || blocks.last().count >= quint32(BLOCK_RECORDS)) {
+        BlockRef ref;
+        ref.offset = m_dataFile.size();
+        ref.firstTs = record.timestamp;
+        ref.lastTs = record.timestamp;
+        ref.count = 0;
+
+        QByteArray header(BLOCK_SIZE, '\0');
+        memcpy(header.data(), &BLOCK_MAGIC, 4);
+        memcpy(header.data() + 4, &id, 4);
+        memcpy(header.data() + 16, &ref.firstTs, 8);
+        memcpy(header.data() + LAST_TS_OFFSET, &ref.lastTs, 8);
+
+        m_dataFile.seek(ref.offset);
+        m_dataFile.write(header);
+        blocks.append(ref);
+
+        // Файл вырос - отображение нужно пересоздать
+        unmap();
+    }
+
+    BlockRef &ref = blocks.last();
+    qint64 slot = ref.count;
+
+    m_dataFile.seek(ref.offset + TS_OFFSET + slot * 8);
+    m_dataFile.write(reinterpret_cast<const char*>(&record.timestamp), 8);
+    m_dataFile.seek(ref.offset + TEMP_OFFSET + slot * 4);
+    m_dataFile.write(reinterpret_cast<const char*>(&record.temp), 4);
+    m_dataFile.seek(ref.offset + FEELS_OFFSET + slot * 4);
+    m_dataFile.write(reinterpret_cast<const char*>(&record.feelsLike), 4);
+    m_dataFile.seek(ref.offset + HUMIDITY_OFFSET + slot * 4);
+    m_dataFile.write(reinterpret_cast<const char*>(&record.humidity), 4);
+    m_dataFile.seek(ref.offset + WIND_OFFSET + slot * 4);
+    m_dataFile.write(reinterpret_cast<const char*>(&record.windSpeed), 4);
+    m_dataFile.seek(ref.offset + CODE_OFFSET + slot);
+    m_dataFile.write(reinterpret_cast<const char*>(&record.weatherCode), 1);
+
+    // Счётчик в заголовке обновляется последним: оборванная запись просто не видна
+    ref.count++;
+    ref.lastTs = record.timestamp;
+    m_dataFile.seek(ref.offset + COUNT_OFFSET);
+    m_dataFile.write(reinterpret_cast<const char*>(&ref.count), 4);
+    m_dataFile.seek(ref.offset + LAST_TS_OFFSET);
+    m_dataFile.write(reinterpret_cast<const char*>(&ref.lastTs), 8);
+    m_dataFile.flush();
+
+    return true;
+}
+
+int ObservationHistory::count(const QString &location, qint64 from, qint64 to)
+{
+    quint32 id = locationId(location, false);
+    auto it = m_blocks.constFind(id);
+    if (it == m_blocks.constEnd() || !ensureMapped()) return 0;
+
+    const QVector<BlockRef> &blocks = it.value();
+    auto first = std::lower_bound(blocks.constBegin(), blocks.constEnd(), from,
+                                  [](const BlockRef &b, qint64 t) { return b.lastTs < t; });
+
+    int total = 0;
+    for (auto b = first; b != blocks.constEnd() && b->firstTs < to; ++b) {
+        const qint64 *ts = reinterpret_cast<const qint64*>(block(*b) + TS_OFFSET);
+        const qint64 *begin = std::lower_bound(ts, ts + b->count, from);
+        const qint64 *end = std::lower_bound(begin, ts + b->count, to);
+        total += int(end - begin);
+    }
+    return total;
+}
+
+QVector<HistoryBucket> ObservationHistory::downsample(const QString &location, Field field,
+                                                      qint64 from, qint64 to, int buckets)
+{
+    HistoryBucket empty;
+    empty.min = 0;
+    empty.max = 0;
+    empty.valid = false;
+    QVector<HistoryBucket> result(qMax(buckets, 0), empty);
+    if (buckets <= 0 || to <= from) return result;
+
+    quint32 id = locationId(location, false);
+    auto it = m_blocks.constFind(id);
+    if (it == m_blocks.constEnd() || !ensureMapped()) return result;
+
+    const QVector<BlockRef> &blocks = it.value();
+    // Блоки упорядочены по времени: первый нужный ищем двоичным поиском
+    auto first = std::lower_bound(blocks.constBegin(), blocks.constEnd(), from,
+                                  [](const BlockRef &b, qint64 t) { return b.lastTs < t; });
+
+    const int valueOffset = columnOffset(field);
+    const double scale = double(buckets) / double(to - from);
+
+    for (auto b = first; b != blocks.constEnd() && b->firstTs < to; ++b) {
+        const uchar *base = block(*b);
+        const qint64 *ts = reinterpret_cast<const qint64*>(base + TS_OFFSET);
+        const float *values = reinterpret_cast<const float*>(base + valueOffset);
+
+        int i = int(std::lower_bound(ts, ts + b->count, from) - ts);
+        for (; i < int(b->count) && ts[i] < to; ++i) {
+            float value = values[i];
+            if (qIsNaN(value)) continue;
+
+            int index = qBound(0, int((ts[i] - from) * scale), buckets - 1);
+            HistoryBucket &bucket = result[index];
+            if (!bucket.valid) {
+                bucket.min = bucket.max = value;
+                bucket.valid = true;
+            } else {
+                bucket.min = qMin(bucket.min, value);
+                bucket.max = qMax(bucket.max, value);
+            }
+        }
+    }
+
+    return result;
+}
+
+int ObservationHistory::columnOffset(Field field)
+{
+    switch (field) {
+    case FeelsLike: return FEELS_OFFSET;
+    case Humidity: return HUMIDITY_OFFSET;
+    case WindSpeed: return WIND_OFFSET;
+    default: return TEMP_OFFSET;
+    }
+}
+
+bool ObservationHistory::ensureMapped()
+{
+    qint64 size = m_dataFile.size();
+    if (m_map && m_mappedSize == size) return true;
+
+    unmap();
+    if (size < BLOCK_SIZE) return false;
+
+    m_map = m_dataFile.map(0, size);
+    if (!m_map) {
+        qWarning() << "Failed to map history file:" << m_dataFile.errorString();
+        return false;
+    }
+    m_mappedSize = size;
+    return true;
+}
+
+void ObservationHistory::unmap()
+{
+    if (m_map) {
+        m_dataFile.unmap(m_map);
+        m_map = nullptr;
+        m_mappedSize = 0;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef OBSERVATIONHISTORY_H
+#define OBSERVATIONHISTORY_H
+
+#include <QFile>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+
+struct HistoryRecord {
+    qint64 timestamp; // секунды от эпохи, UTC
+    float temp;
+    float feelsLike;
+    float humidity;
+    float windSpeed;
+    quint8 weatherCode;
+};
+
+struct HistoryBucket {
+    float min;
+    float max;
+    bool valid;
+};
+
+// Журнал наблюдений: файл из блоков фиксированного размера, каждый блок
+// принадлежит одному городу и хранит до BLOCK_RECORDS записей по столбцам.
+// Запись - дописыванием в последний блок города, чтение - через mmap.
+class ObservationHistory
+{
+public:
+    enum Field {
+        Temperature,
+        FeelsLike,
+        Humidity,
+        WindSpeed
+    };
+
+    ObservationHistory();
+    ~ObservationHistory();
+
+    bool open(const QString &directory);
+    bool append(const QString &location, const HistoryRecord &record);
+
+    int count(const QString &location, qint64 from, qint64 to);
+    // Минимум и максимум поля в каждом из buckets равных интервалов [from, to)
+    QVector<HistoryBucket> downsample(const QString &location, Field field,
+                                      qint64 from, qint64 to, int buckets);
+
+private:
+    struct BlockRef {
+        qint64 offset;
+        qint64 firstTs;
+        qint64 lastTs;
+        quint32 count;
+    };
+
+    quint32 locationId(const QString &location, bool create);
+    void buildIndex();
+    bool ensureMapped();
+    void unmap();
+    const uchar *block(const BlockRef &ref) const { return m_map + ref.offset; }
+    static int columnOffset(Field field);
+
+    QFile m_dataFile;
+    QFile m_locationsFile;
+    uchar *m_map;
+    qint64 m_mappedSize;
+
+    QStringList m_locations;
+    QHash<QString, quint32> m_locationIds;
+    QHash<quint32, QVector<BlockRef>> m_blocks;
+};
+
+#endif // OBSERVATIONHISTORY_H
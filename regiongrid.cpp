@@ -0,0 +1,288 @@
+#include "regiongrid.h"
+#include <QNetworkReply>
+#include <QUrlQuery>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QDateTime>
+#include <QtConcurrent>
+#include <QtMath>
+#include <QDebug>
+
+namespace {
+const double ZOOM_STEPS[] = { 1.0, 0.5, 0.25, 0.1 };
+const int BATCH_SIZE = 50;
+const qint64 CELL_TTL_MS = 15 * 60 * 1000;
+const int TILE_SIZE = 64;
+
+struct ColorStop {
+    float value;
+    int r, g, b;
+};
+
+const ColorStop TEMPERATURE_STOPS[] = {
+    { -30, 49, 54, 149 }, { -15, 69, 117, 180 }, { 0, 171, 217, 233 }, { 10, 255, 255, 191 },
+    { 20, 253, 174, 97 }, { 30, 215, 48, 39 }, { 40, 165, 0, 38 }
+};
+
+const ColorStop PRECIPITATION_STOPS[] = {
+    { 0, 240, 240, 240 }, { 0.5f, 198, 219, 239 }, { 2, 107, 174, 214 },
+    { 5, 33, 113, 181 }, { 10, 8, 48, 107 }
+};
+
+template <int N>
+QRgb ramp(const ColorStop (&stops)[N], float value)
+{
+    if (value <= stops[0].value) return qRgb(stops[0].r, stops[0].g, stops[0].b);
+    for (int i = 1; i < N; ++i) {
+        if (value > stops[i].value) continue;
+        float t = (value - stops[i - 1].value) / (stops[i].value - stops[i - 1].value);
+        return qRgb(int(stops[i - 1].r + t * (stops[i].r - stops[i - 1].r)),
+                    int(stops[i - 1].g + t * (stops[i].g - stops[i - 1].g)),
+                    int(stops[i - 1].b + t * (stops[i].b - stops[i - 1].b)));
+    }
+    return qRgb(stops[N - 1].r, stops[N - 1].g, stops[N - 1].b);
+}
+
+int columnsPerWorld(int zoom)
+{
+    return qRound(360.0 / RegionGrid::stepForZoom(zoom));
+}
+
+float fieldValue(const GridCell &cell, RegionGrid::Field field)
+{
+    return field == RegionGrid::Temperature ? cell.temp : cell.precipitation;
+}
+}
+
+RegionGrid::RegionGrid(RequestScheduler *scheduler, const QString &apiUrl, QObject *parent)
+    : QObject(parent)
+    , m_scheduler(scheduler)
+    , m_apiUrl(apiUrl)
+{
+}
+
+int RegionGrid::zoomLevels()
+{
+    return int(sizeof(ZOOM_STEPS) / sizeof(ZOOM_STEPS[0]));
+}
+
+double RegionGrid::stepForZoom(int zoom)
+{
+    return ZOOM_STEPS[qBound(0, zoom, zoomLevels() - 1)];
+}
+
+int RegionGrid::rowFor(double lat, int zoom)
+{
+    return int(qFloor(lat / stepForZoom(zoom)));
+}
+
+int RegionGrid::colFor(double lon, int zoom)
+{
+    return int(qFloor(lon / stepForZoom(zoom)));
+}
+
+GeoPoint RegionGrid::cellCenter(int row, int col, int zoom)
+{
+    double step = stepForZoom(zoom);
+    GeoPoint point;
+    point.lat = (row + 0.5) * step;
+    // Долгота сворачивается в [-180, 180): окно может переходить через антимеридиан
+    double lon = std::fmod((col + 0.5) * step + 180.0, 360.0);
+    if (lon < 0) lon += 360.0;
+    point.lon = lon - 180.0;
+    return point;
+}
+
+quint64 RegionGrid::cellKey(int zoom, int row, int col)
+{
+    int wrap = columnsPerWorld(zoom);
+    int wrapped = ((col % wrap) + wrap) % wrap;
+    return (quint64(zoom) << 40) | (quint64(row + (1 << 19)) << 20) | quint64(wrapped);
+}
+
+GridWindow RegionGrid::window(int zoom, int row0, int col0, int rows, int cols)
+{
+    GridWindow window;
+    window.zoom = zoom;
+    window.row0 = row0;
+    window.col0 = col0;
+    window.rows = rows;
+    window.cols = cols;
+    window.revision = m_revisions.value(zoom);
+    window.cells.resize(rows * cols);
+
+    GridCell empty;
+    empty.temp = float(qQNaN());
+    empty.precipitation = float(qQNaN());
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QVector<QPair<int, int>> missing;
+
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            GridCell &cell = window.cells[r * cols + c];
+            cell = empty;
+
+            int row = row0 + r;
+            int col = col0 + c;
+            if (qAbs(cellCenter(row, col, zoom).lat) >= 90.0) continue;
+
+            quint64 key = cellKey(zoom, row, col);
+            auto it = m_cells.constFind(key);
+            bool stale = true;
+            if (it != m_cells.constEnd()) {
+                // Устаревшее значение показываем, пока не придёт свежее
+                cell = it.value().value;
+                stale = now - it.value().fetchedAt > CELL_TTL_MS;
+            }
+            if (stale && !m_pending.contains(key)) {
+                m_pending.insert(key);
+                missing.append(qMakePair(row, col));
+            }
+        }
+    }
+
+    for (int i = 0; i < missing.size(); i += BATCH_SIZE) {
+        fetch(zoom, missing.mid(i, BATCH_SIZE));
+    }
+    return window;
+}
+
+void RegionGrid::fetch(int zoom, const QVector<QPair<int, int>> &cells)
+{
+    QStringList latitudes;
+    QStringList longitudes;
+    for (const auto &cell : cells) {
+        GeoPoint point = cellCenter(cell.first, cell.second, zoom);
+        latitudes << QString::number(point.lat, 'f', 4);
+        longitudes << QString::number(point.lon, 'f', 4);
+    }
+
+    // Несколько точек одним запросом: ответ - массив в том же порядке
+    QUrl url(m_apiUrl);
+    QUrlQuery query;
+    query.addQueryItem("latitude", latitudes.join(','));
+    query.addQueryItem("longitude", longitudes.join(','));
+    query.addQueryItem("current", "temperature_2m,precipitation");
+    query.addQueryItem("timeformat", "unixtime");
+    url.setQuery(query);
+
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::UserAgentHeader, "SimpleWeather/1.0");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    request.setTransferTimeout(15000);
+#endif
+
+    m_scheduler->get(request, RequestScheduler::CurrentCity, "heatmap", this,
+                     [this, zoom, cells](QNetworkReply *reply) {
+        onBatchFinished(zoom, cells, reply);
+    });
+
+    qDebug() << "Grid batch requested: zoom" << zoom << "points:" << cells.size();
+}
+
+void RegionGrid::onBatchFinished(int zoom, const QVector<QPair<int, int>> &cells, QNetworkReply *reply)
+{
+    for (const auto &cell : cells) {
+        m_pending.remove(cellKey(zoom, cell.first, cell.second));
+    }
+
+    if (reply->error() != QNetworkReply::NoError) {
+        qDebug() << "Grid batch error:" << reply->errorString();
+        return;
+    }
+
+    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+    QJsonArray locations;
+    if (doc.isArray()) {
+        locations = doc.array();
+    } else {
+        // Для одной точки API возвращает объект, а не массив
+        locations.append(doc.object());
+    }
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    int count = qMin(cells.size(), locations.size());
+    for (int i = 0; i < count; ++i) {
+        QJsonObject current = locations[i].toObject()["current"].toObject();
+        QJsonValue temp = current["temperature_2m"];
+        QJsonValue precipitation = current["precipitation"];
+
+        StoredCell stored;
+        stored.value.temp = temp.isDouble() ? float(temp.toDouble()) : float(qQNaN());
+        stored.value.precipitation = precipitation.isDouble() ? float(precipitation.toDouble()) : float(qQNaN());
+        stored.fetchedAt = now;
+        m_cells.insert(cellKey(zoom, cells[i].first, cells[i].second), stored);
+    }
+
+    m_revisions[zoom]++;
+    emit cellsArrived(zoom);
+}
+
+QRgb RegionGrid::colorFor(Field field, float value)
+{
+    return field == Temperature ? ramp(TEMPERATURE_STOPS, value) : ramp(PRECIPITATION_STOPS, value);
+}
+
+QImage RegionGrid::rasterize(const GridWindow &window, Field field, const QSize &size)
+{
+    QImage image(size, QImage::Format_ARGB32);
+    if (image.isNull() || window.rows == 0 || window.cols == 0) return image;
+
+    // Плитки пишут в непересекающиеся участки одного буфера; bits() вызывается
+    // здесь один раз, чтобы отсоединение копии не случилось внутри потоков
+    uchar *bits = image.bits();
+    const int bytesPerLine = image.bytesPerLine();
+    const int width = size.width();
+    const int height = size.height();
+
+    QVector<QRect> tiles;
+    for (int y = 0; y < height; y += TILE_SIZE) {
+        for (int x = 0; x < width; x += TILE_SIZE) {
+            tiles.append(QRect(x, y, qMin(TILE_SIZE, width - x), qMin(TILE_SIZE, height - y)));
+        }
+    }
+
+    QtConcurrent::blockingMap(tiles, [&window, field, bits, bytesPerLine, width, height](const QRect &tile) {
+        const QRgb missing = qRgba(128, 128, 128, 60);
+        for (int y = tile.top(); y <= tile.bottom(); ++y) {
+            QRgb *line = reinterpret_cast<QRgb*>(bits + y * bytesPerLine);
+            // Север сверху: строка решётки растёт вверх по изображению
+            double gy = (height - 0.5 - y) / height * window.rows - 0.5;
+            int r0 = qBound(0, int(qFloor(gy)), window.rows - 1);
+            int r1 = qMin(r0 + 1, window.rows - 1);
+            double ty = qBound(0.0, gy - r0, 1.0);
+
+            for (int x = tile.left(); x <= tile.right(); ++x) {
+                double gx = (x + 0.5) / width * window.cols - 0.5;
+                int c0 = qBound(0, int(qFloor(gx)), window.cols - 1);
+                int c1 = qMin(c0 + 1, window.cols - 1);
+                double tx = qBound(0.0, gx - c0, 1.0);
+
+                // Билинейная интерполяция; пропуски не тянут значение к нулю
+                const float values[4] = {
+                    fieldValue(window.cells[r0 * window.cols + c0], field),
+                    fieldValue(window.cells[r0 * window.cols + c1], field),
+                    fieldValue(window.cells[r1 * window.cols + c0], field),
+                    fieldValue(window.cells[r1 * window.cols + c1], field)
+                };
+                const double weights[4] = {
+                    (1 - tx) * (1 - ty), tx * (1 - ty), (1 - tx) * ty, tx * ty
+                };
+
+                double sum = 0;
+                double weight = 0;
+                for (int k = 0; k < 4; ++k) {
+                    if (qIsNaN(values[k])) continue;
+                    sum += values[k] * weights[k];
+                    weight += weights[k];
+                }
+
+                line[x] = weight > 1e-6 ? colorFor(field, float(sum / weight)) : missing;
+            }
+        }
+    });
+
+    return image;
+}
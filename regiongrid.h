@@ -0,0 +1,80 @@
+#ifndef REGIONGRID_H
+#define REGIONGRID_H
+
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QSet>
+#include <QVector>
+#include "cityindex.h"
+#include "requestscheduler.h"
+
+class QNetworkReply;
+
+// Значения в узле решётки; NaN - нет данных
+struct GridCell {
+    float temp;
+    float precipitation;
+};
+
+// Прямоугольное окно решётки одного масштаба: rows x cols узлов, строки с юга на север
+struct GridWindow {
+    int zoom;
+    int row0;
+    int col0;
+    int rows;
+    int cols;
+    quint32 revision; // меняется, когда для масштаба приходят новые данные
+    QVector<GridCell> cells;
+};
+
+// Узлы лежат на общей для всех видов решётке с шагом, зависящим от масштаба:
+// при сдвиге окна уже загруженные узлы переиспользуются. Недостающие узлы
+// запрашиваются пачками координат в одном запросе Open-Meteo.
+class RegionGrid : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Field {
+        Temperature,
+        Precipitation
+    };
+
+    RegionGrid(RequestScheduler *scheduler, const QString &apiUrl, QObject *parent = nullptr);
+
+    static int zoomLevels();
+    static double stepForZoom(int zoom); // градусы между узлами
+    static int rowFor(double lat, int zoom);
+    static int colFor(double lon, int zoom);
+    static GeoPoint cellCenter(int row, int col, int zoom);
+
+    // Окно из кэша; для недостающих и устаревших узлов уходят запросы
+    GridWindow window(int zoom, int row0, int col0, int rows, int cols);
+    int pendingCells() const { return m_pending.size(); }
+
+    // Растеризация окна в изображение: плитки считаются параллельно
+    static QImage rasterize(const GridWindow &window, Field field, const QSize &size);
+    static QRgb colorFor(Field field, float value);
+
+signals:
+    void cellsArrived(int zoom);
+
+private:
+    struct StoredCell {
+        GridCell value;
+        qint64 fetchedAt;
+    };
+
+    static quint64 cellKey(int zoom, int row, int col);
+    void fetch(int zoom, const QVector<QPair<int, int>> &cells);
+    void onBatchFinished(int zoom, const QVector<QPair<int, int>> &cells, QNetworkReply *reply);
+
+    RequestScheduler *m_scheduler;
+    QString m_apiUrl;
+    QHash<quint64, StoredCell> m_cells;
+    QSet<quint64> m_pending;
+    QHash<int, quint32> m_revisions;
+};
+
+#endif // REGIONGRID_H
@@ -0,0 +1,317 @@
+#include "requestscheduler.h"
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QDateTime>
+#include <QDebug>
+
+namespace {
+const int DEFAULT_HOST_LIMIT = 6;
+// Фоновые классы не занимают последний слот хоста - он остаётся интерактивным запросам
+const int RESERVED_SLOTS = 1;
+// После стольких вытеснений запрос больше не вытесняется, чтобы не голодать
+const int MAX_PREEMPTIONS = 3;
+const char *PRIORITY_NAMES[] = { "interactive", "current", "favorites", "prefetch" };
+
+bool isBackground(RequestScheduler::Priority priority)
+{
+    return priority >= RequestScheduler::Favorites;
+}
+}
+
+RequestScheduler::RequestScheduler(QNetworkAccessManager *network, QObject *parent)
+    : QObject(parent)
+    , m_network(network)
+    , m_defaultHostLimit(DEFAULT_HOST_LIMIT)
+    , m_nextTicket(1)
+{
+    for (Stats &stats : m_stats) {
+        stats.started = 0;
+        stats.preempted = 0;
+        stats.totalWaitMs = 0;
+        stats.maxWaitMs = 0;
+    }
+}
+
+RequestScheduler::~RequestScheduler()
+{
+    // Колбэки владельцев при закрытии уже не нужны: ответы обрываются молча
+    QHash<Ticket, Running> running = m_running;
+    m_running.clear();
+    for (const Running &entry : running) {
+        entry.reply->abort();
+        entry.reply->deleteLater();
+    }
+    logStats();
+}
+
+void RequestScheduler::setDefaultHostLimit(int limit)
+{
+    m_defaultHostLimit = qMax(1, limit);
+    schedule();
+}
+
+void RequestScheduler::setHostLimit(const QString &host, int limit)
+{
+    m_hostLimits.insert(host, qMax(1, limit));
+    schedule();
+}
+
+RequestScheduler::Ticket RequestScheduler::get(const QNetworkRequest &request, Priority priority,
+                                               const QString &group, QObject *context,
+                                               const Callback &onFinished,
+                                               const StartedCallback &onStarted)
+{
+    Job job;
+    job.ticket = m_nextTicket++;
+    job.request = request;
+    job.priority = priority;
+    job.group = group;
+    job.context = context;
+    job.callback = onFinished;
+    job.started = onStarted;
+    job.queuedAt = QDateTime::currentMSecsSinceEpoch();
+    job.preemptions = 0;
+
+    // Интерактивный запрос не ждёт фоновых: при занятом хосте один фоновый уступает место
+    if (!canStart(job) && !isBackground(priority)) {
+        preemptFor(job);
+    }
+
+    enqueue(job, false);
+    schedule();
+    return job.ticket;
+}
+
+void RequestScheduler::cancel(Ticket ticket)
+{
+    Job job;
+    if (takeQueued(ticket, &job)) return;
+
+    auto running = m_running.find(ticket);
+    if (running == m_running.end()) return;
+
+    // Запись убирается до abort(): синхронный finished её уже не найдёт
+    QNetworkReply *reply = running.value().reply;
+    QString host = running.value().job.request.url().host();
+    m_running.erase(running);
+    m_hostActive[host]--;
+
+    reply->abort();
+    schedule();
+}
+
+void RequestScheduler::raise(Ticket ticket, Priority priority)
+{
+    auto running = m_running.find(ticket);
+    if (running != m_running.end()) {
+        // Ответ уже в пути: перезапуск только отодвинул бы его
+        Job &job = running.value().job;
+        if (priority < job.priority) {
+            job.priority = priority;
+        }
+        return;
+    }
+
+    auto queued = m_queued.constFind(ticket);
+    if (queued == m_queued.constEnd() || queued.value() <= priority) return;
+
+    Job job;
+    if (!takeQueued(ticket, &job)) return;
+    qDebug() << "Scheduler raised" << PRIORITY_NAMES[job.priority] << "request to"
+             << PRIORITY_NAMES[priority] << job.group;
+    job.priority = priority;
+
+    if (!canStart(job) && !isBackground(priority)) {
+        preemptFor(job);
+    }
+    enqueue(job, true);
+    schedule();
+}
+
+bool RequestScheduler::isActive(Ticket ticket) const
+{
+    return m_queued.contains(ticket) || m_running.contains(ticket);
+}
+
+void RequestScheduler::logStats() const
+{
+    for (int priority = 0; priority < PriorityCount; ++priority) {
+        const Stats &stats = m_stats[priority];
+        if (stats.started == 0) continue;
+        qDebug() << "Scheduler" << PRIORITY_NAMES[priority] << "started:" << stats.started
+                 << "preempted:" << stats.preempted
+                 << "avg wait ms:" << stats.totalWaitMs / stats.started
+                 << "max wait ms:" << stats.maxWaitMs;
+    }
+}
+
+int RequestScheduler::hostLimit(const QString &host) const
+{
+    return m_hostLimits.value(host, m_defaultHostLimit);
+}
+
+bool RequestScheduler::canStart(const Job &job) const
+{
+    QString host = job.request.url().host();
+    int limit = hostLimit(host);
+    if (isBackground(job.priority) && limit > RESERVED_SLOTS) {
+        limit -= RESERVED_SLOTS;
+    }
+    return m_hostActive.value(host) < limit;
+}
+
+void RequestScheduler::enqueue(const Job &job, bool front)
+{
+    Lane &lane = m_lanes[job.priority];
+    QQueue<Job> &queue = lane.queues[job.group];
+    if (queue.isEmpty()) {
+        // Вытесненная группа встаёт первой, новая - в конец круга
+        if (front) {
+            lane.groups.prepend(job.group);
+        } else {
+            lane.groups.append(job.group);
+        }
+    }
+
+    if (front) {
+        queue.prepend(job);
+    } else {
+        queue.enqueue(job);
+    }
+    m_queued.insert(job.ticket, job.priority);
+}
+
+bool RequestScheduler::takeQueued(Ticket ticket, Job *job)
+{
+    auto queued = m_queued.find(ticket);
+    if (queued == m_queued.end()) return false;
+
+    Lane &lane = m_lanes[queued.value()];
+    m_queued.erase(queued);
+
+    for (int i = 0; i < lane.groups.size(); ++i) {
+        QQueue<Job> &queue = lane.queues[lane.groups[i]];
+        for (int j = 0; j < queue.size(); ++j) {
+            if (queue[j].ticket != ticket) continue;
+            *job = queue.takeAt(j);
+            if (queue.isEmpty()) {
+                lane.queues.remove(lane.groups[i]);
+                lane.groups.removeAt(i);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void RequestScheduler::schedule()
+{
+    for (int priority = 0; priority < PriorityCount; ++priority) {
+        Lane &lane = m_lanes[priority];
+
+        // Обход по кругу: группа, получившая слот, уходит в конец
+        int i = 0;
+        while (i < lane.groups.size()) {
+            QString group = lane.groups[i];
+            QQueue<Job> &queue = lane.queues[group];
+            if (!canStart(queue.head())) {
+                ++i;
+                continue;
+            }
+
+            Job job = queue.dequeue();
+            m_queued.remove(job.ticket);
+            lane.groups.removeAt(i);
+            if (queue.isEmpty()) {
+                lane.queues.remove(group);
+            } else {
+                lane.groups.append(group);
+            }
+
+            start(job);
+        }
+    }
+}
+
+void RequestScheduler::start(const Job &job)
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 waited = now - job.queuedAt;
+    Stats &stats = m_stats[job.priority];
+    stats.started++;
+    stats.totalWaitMs += waited;
+    stats.maxWaitMs = qMax(stats.maxWaitMs, waited);
+
+    Running running;
+    running.job = job;
+    running.reply = m_network->get(job.request);
+    running.startedAt = now;
+    m_running.insert(job.ticket, running);
+    m_hostActive[job.request.url().host()]++;
+
+    Ticket ticket = job.ticket;
+    QNetworkReply *reply = running.reply;
+    connect(reply, &QNetworkReply::finished, this, [this, ticket, reply]() {
+        onFinished(ticket, reply);
+    });
+
+    if (job.started && job.context) {
+        job.started();
+    }
+}
+
+bool RequestScheduler::preemptFor(const Job &job)
+{
+    QString host = job.request.url().host();
+
+    // Жертва - самый низкий класс, среди равных - запущенный последним (меньше потеряет)
+    Ticket victim = 0;
+    const Running *chosen = nullptr;
+    for (auto it = m_running.constBegin(); it != m_running.constEnd(); ++it) {
+        const Running &candidate = it.value();
+        if (!isBackground(candidate.job.priority)) continue;
+        if (candidate.job.preemptions >= MAX_PREEMPTIONS) continue;
+        if (candidate.job.request.url().host() != host) continue;
+
+        if (!chosen || candidate.job.priority > chosen->job.priority
+                || (candidate.job.priority == chosen->job.priority && candidate.startedAt > chosen->startedAt)) {
+            chosen = &candidate;
+            victim = it.key();
+        }
+    }
+    if (!chosen) return false;
+
+    Running running = m_running.take(victim);
+    m_hostActive[host]--;
+    m_stats[running.job.priority].preempted++;
+
+    qDebug() << "Scheduler preempted" << PRIORITY_NAMES[running.job.priority]
+             << "request for" << PRIORITY_NAMES[job.priority] << running.job.group;
+
+    // Вытесненный запрос возвращается в голову своей очереди и будет повторён
+    Job requeued = running.job;
+    requeued.preemptions++;
+    enqueue(requeued, true);
+
+    running.reply->abort();
+    return true;
+}
+
+void RequestScheduler::onFinished(Ticket ticket, QNetworkReply *reply)
+{
+    reply->deleteLater();
+
+    // Отменённый или вытесненный запрос: запись уже убрана
+    auto it = m_running.find(ticket);
+    if (it == m_running.end() || it.value().reply != reply) return;
+
+    Running running = it.value();
+    m_running.erase(it);
+    m_hostActive[running.job.request.url().host()]--;
+
+    if (running.job.context) {
+        running.job.callback(reply);
+    }
+
+    schedule();
+}
@@ -0,0 +1,109 @@
+#ifndef REQUESTSCHEDULER_H
+#define REQUESTSCHEDULER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QQueue>
+#include <functional>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+// Очередь перед менеджером сети: классы приоритета, лимит одновременных запросов
+// на хост, вытеснение фоновых запросов и чередование городов внутри класса.
+// Ответ передаётся в колбэк и удаляется планировщиком после него.
+class RequestScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Priority {
+        Interactive,    // поиск и подсказки
+        CurrentCity,    // текущий город: снимок, модели, детализация
+        Favorites,      // обновление избранного, сервер
+        Prefetch,       // упреждающая загрузка, архив
+        PriorityCount
+    };
+
+    typedef quint64 Ticket;
+    typedef std::function<void(QNetworkReply *reply)> Callback;
+    typedef std::function<void()> StartedCallback;
+
+    explicit RequestScheduler(QNetworkAccessManager *network, QObject *parent = nullptr);
+    ~RequestScheduler();
+
+    QNetworkAccessManager *network() const { return m_network; }
+
+    void setDefaultHostLimit(int limit);
+    void setHostLimit(const QString &host, int limit);
+
+    // group - город или другой ключ, между которыми чередуются запросы одного класса.
+    // Колбэк не вызывается, если context уже удалён или запрос отменён.
+    // onStarted - когда запрос покинул очередь (и при повторе после вытеснения)
+    Ticket get(const QNetworkRequest &request, Priority priority, const QString &group,
+               QObject *context, const Callback &onFinished,
+               const StartedCallback &onStarted = StartedCallback());
+    void cancel(Ticket ticket);
+    // Повысить класс запроса, которого теперь ждёт пользователь: ожидающий
+    // переходит в новую очередь, уже запущенный перестаёт быть кандидатом на вытеснение
+    void raise(Ticket ticket, Priority priority);
+    bool isActive(Ticket ticket) const;
+
+    void logStats() const;
+
+private:
+    struct Job {
+        Ticket ticket;
+        QNetworkRequest request;
+        Priority priority;
+        QString group;
+        QPointer<QObject> context;
+        Callback callback;
+        StartedCallback started;
+        qint64 queuedAt;
+        int preemptions;
+    };
+
+    struct Running {
+        Job job;
+        QNetworkReply *reply;
+        qint64 startedAt;
+    };
+
+    // Очереди одного класса по группам; группы обходятся по кругу
+    struct Lane {
+        QList<QString> groups;
+        QHash<QString, QQueue<Job>> queues;
+    };
+
+    struct Stats {
+        int started;
+        int preempted;
+        qint64 totalWaitMs;
+        qint64 maxWaitMs;
+    };
+
+    int hostLimit(const QString &host) const;
+    bool canStart(const Job &job) const;
+    void enqueue(const Job &job, bool front);
+    bool takeQueued(Ticket ticket, Job *job);
+    void schedule();
+    void start(const Job &job);
+    bool preemptFor(const Job &job);
+    void onFinished(Ticket ticket, QNetworkReply *reply);
+
+    QNetworkAccessManager *m_network;
+    Lane m_lanes[PriorityCount];
+    QHash<Ticket, Priority> m_queued;
+    QHash<Ticket, Running> m_running;
+    QHash<QString, int> m_hostActive;
+    QHash<QString, int> m_hostLimits;
+    int m_defaultHostLimit;
+    Ticket m_nextTicket;
+    Stats m_stats[PriorityCount];
+};
+
+#endif // REQUESTSCHEDULER_H
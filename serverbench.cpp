@@ -0,0 +1,240 @@
+#include "serverbench.h"
+#include "weatherserver.h"
+#include "weatherservice.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDateTime>
+#include <QTextStream>
+#include <QVector>
+#include <QHash>
+#include <QSharedPointer>
+#include <algorithm>
+
+namespace {
+const int CITY_COUNT = 10;
+const int UPSTREAM_DELAY_MS = 200;
+const int WAVE_TIMEOUT_MS = 30000;
+
+// Ответ в форме краткого запроса сервиса: текущая погода, сутки по часам, дни
+QByteArray forecastBody()
+{
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+
+    QJsonObject current;
+    current["time"] = double(now);
+    current["temperature_2m"] = 12.5;
+    current["apparent_temperature"] = 11.0;
+    current["relative_humidity_2m"] = 70;
+    current["wind_speed_10m"] = 3.2;
+    current["weather_code"] = 2;
+
+    QJsonArray times, tempMax, tempMin, codes;
+    for (int d = 0; d < 7; ++d) {
+        times.append(double(now - now % 86400 + d * 86400));
+        tempMax.append(15.0 + d);
+        tempMin.append(5.0 + d);
+        codes.append(d % 4);
+    }
+    QJsonObject daily;
+    daily["time"] = times;
+    daily["temperature_2m_max"] = tempMax;
+    daily["temperature_2m_min"] = tempMin;
+    daily["weather_code"] = codes;
+
+    QJsonArray hourlyTemps, hourlyCodes;
+    for (int h = 0; h < 24; ++h) {
+        hourlyTemps.append(8.0 + h % 12);
+        hourlyCodes.append(h % 4);
+    }
+    QJsonObject hourly;
+    hourly["temperature_2m"] = hourlyTemps;
+    hourly["weather_code"] = hourlyCodes;
+
+    QJsonObject forecast;
+    forecast["utc_offset_seconds"] = 0;
+    forecast["current"] = current;
+    forecast["daily"] = daily;
+    forecast["hourly"] = hourly;
+    return QJsonDocument(forecast).toJson(QJsonDocument::Compact);
+}
+
+// Заглушка Open-Meteo: отвечает с фиксированной задержкой и считает запросы
+class FakeUpstream : public QObject
+{
+public:
+    FakeUpstream()
+        : m_body(forecastBody())
+        , m_requests(0)
+    {
+        connect(&m_server, &QTcpServer::newConnection, this, [this]() {
+            while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+                connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+                connect(socket, &QTcpSocket::readyRead, socket, [this, socket]() {
+                    QByteArray buffer = socket->property("buffer").toByteArray() + socket->readAll();
+                    socket->setProperty("buffer", buffer);
+                    if (!buffer.contains("\r\n\r\n") || socket->property("answered").toBool()) return;
+                    socket->setProperty("answered", true);
+                    ++m_requests;
+                    QTimer::singleShot(UPSTREAM_DELAY_MS, socket, [this, socket]() {
+                        QByteArray response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                                              "Content-Length: " + QByteArray::number(m_body.size())
+                                              + "\r\nConnection: close\r\n\r\n" + m_body;
+                        socket->write(response);
+                        socket->disconnectFromHost();
+                    });
+                });
+            }
+        });
+    }
+
+    bool listen() { return m_server.listen(QHostAddress::LocalHost, 0); }
+    quint16 port() const { return m_server.serverPort(); }
+    int requests() const { return m_requests; }
+
+private:
+    QTcpServer m_server;
+    QByteArray m_body;
+    int m_requests;
+};
+
+struct WaveResult {
+    int ok;
+    int failed;
+    QVector<double> latencies;
+    qint64 wallMs;
+};
+
+WaveResult runWave(quint16 port, int clients)
+{
+    WaveResult result;
+    result.ok = 0;
+    result.failed = 0;
+
+    QEventLoop loop;
+    int remaining = clients;
+    QElapsedTimer wall;
+    wall.start();
+
+    for (int i = 0; i < clients; ++i) {
+        QTcpSocket *socket = new QTcpSocket(&loop);
+        QByteArray request = "GET /weather?city=City%20" + QByteArray::number(i % CITY_COUNT)
+                + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        QSharedPointer<QElapsedTimer> timer(new QElapsedTimer);
+        timer->start();
+
+        QObject::connect(socket, &QTcpSocket::connected, socket, [socket, request]() { socket->write(request); });
+        // Сервер закрывает соединение после ответа; ошибка соединения тоже завершает клиента
+        auto done = [&, socket, timer]() {
+            if (socket->property("done").toBool()) return;
+            socket->setProperty("done", true);
+            QByteArray response = socket->readAll();
+            if (response.startsWith("HTTP/1.1 200")) {
+                ++result.ok;
+                result.latencies.append(timer->nsecsElapsed() / 1000000.0);
+            } else {
+                ++result.failed;
+            }
+            socket->deleteLater();
+            if (--remaining == 0) loop.quit();
+        };
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, done);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+        QObject::connect(socket, &QTcpSocket::errorOccurred, socket, done);
+#else
+        QObject::connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), socket, done);
+#endif
+        socket->connectToHost(QHostAddress::LocalHost, port);
+    }
+
+    QTimer::singleShot(WAVE_TIMEOUT_MS, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    // Не успевшие клиенты удаляются до выхода: их сигналы ссылаются на локальные счётчики
+    const QList<QTcpSocket*> leftovers = loop.findChildren<QTcpSocket*>();
+    for (QTcpSocket *socket : leftovers) {
+        socket->disconnect();
+        delete socket;
+    }
+
+    result.failed += remaining;
+    result.wallMs = wall.elapsed();
+    std::sort(result.latencies.begin(), result.latencies.end());
+    return result;
+}
+
+double percentile(const QVector<double> &sorted, double p)
+{
+    if (sorted.isEmpty()) return 0;
+    return sorted[qMin(sorted.size() - 1, int(sorted.size() * p))];
+}
+
+void report(const char *name, const WaveResult &wave, int upstream, QTextStream &out)
+{
+    out << "  " << QString(name).leftJustified(6)
+        << "ok " << wave.ok << ", failed " << wave.failed
+        << ", p50 " << QString::number(percentile(wave.latencies, 0.5), 'f', 1) << " ms"
+        << ", p95 " << QString::number(percentile(wave.latencies, 0.95), 'f', 1) << " ms"
+        << ", max " << QString::number(wave.latencies.isEmpty() ? 0 : wave.latencies.last(), 'f', 1) << " ms"
+        << ", wall " << wave.wallMs << " ms"
+        << ", " << QString::number(wave.ok * 1000.0 / qMax<qint64>(wave.wallMs, 1), 'f', 0) << " req/s"
+        << ", upstream requests " << upstream << "\n";
+    out.flush();
+}
+}
+
+int runServerBenchmark(int clients)
+{
+    QTextStream out(stdout);
+    clients = qMax(clients, 1);
+
+    FakeUpstream upstream;
+    if (!upstream.listen()) {
+        out << "Failed to start the upstream stub\n";
+        return 1;
+    }
+    QString base = QString("http://127.0.0.1:%1").arg(upstream.port());
+    WeatherService service(base + "/v1/forecast", base + "/v1/search");
+
+    QHash<QString, GeoPoint> cities;
+    for (int i = 0; i < CITY_COUNT; ++i) {
+        GeoPoint point = { 50.0 + i, 10.0 + i };
+        cities.insert(QString("City %1").arg(i), point);
+    }
+
+    WeatherServer server(&service);
+    server.setLocationsProvider([cities]() { return cities.keys(); });
+    server.setLocationResolver([cities](const QString &city, GeoPoint *point) {
+        auto found = cities.constFind(city);
+        if (found == cities.constEnd()) return false;
+        *point = found.value();
+        return true;
+    });
+    if (!server.listen(0, QHostAddress::LocalHost)) {
+        out << "Failed to start the weather server\n";
+        return 1;
+    }
+
+    out << clients << " concurrent clients, " << CITY_COUNT << " cities, upstream delay "
+        << UPSTREAM_DELAY_MS << " ms:\n";
+
+    // Холодный кэш: на каждый город должен уйти один запрос, остальные клиенты ждут его
+    WaveResult cold = runWave(server.serverPort(), clients);
+    int coldUpstream = upstream.requests();
+    report("cold", cold, coldUpstream, out);
+
+    WaveResult warm = runWave(server.serverPort(), clients);
+    report("warm", warm, upstream.requests() - coldUpstream, out);
+
+    const WeatherService::Stats stats = service.stats();
+    out << "  service: fetches " << stats.fetches << ", cache hits " << stats.cacheHits
+        << ", coalesced " << stats.coalesced << ", errors " << stats.errors << "\n";
+
+    return (cold.failed == 0 && warm.failed == 0) ? 0 : 1;
+}
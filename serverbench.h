@@ -0,0 +1,9 @@
+#ifndef SERVERBENCH_H
+#define SERVERBENCH_H
+
+// Нагрузочный замер встроенного HTTP-сервера: сотни одновременных клиентов
+// против локальной заглушки Open-Meteo, холодный и тёплый кэш.
+// Запуск: SimpleWeather --bench-server 300 или make server-bench
+int runServerBenchmark(int clients);
+
+#endif // SERVERBENCH_H
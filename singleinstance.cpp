@@ -0,0 +1,83 @@
+#include "singleinstance.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QCryptographicHash>
+#include <QCoreApplication>
+#include <QDebug>
+
+SingleInstance::SingleInstance(QObject *parent)
+    : QObject(parent)
+    , m_server(new QLocalServer(this))
+{
+    connect(m_server, &QLocalServer::newConnection, this, &SingleInstance::onNewConnection);
+}
+
+QString SingleInstance::serverName()
+{
+    // На Unix имя сокета общее для всех пользователей - добавляем хеш имени пользователя
+    QByteArray user = qgetenv("USER");
+    if (user.isEmpty()) {
+        user = qgetenv("USERNAME");
+    }
+    QByteArray hash = QCryptographicHash::hash(user, QCryptographicHash::Sha1).toHex().left(12);
+    return QCoreApplication::applicationName() + "-" + QString::fromLatin1(hash);
+}
+
+bool SingleInstance::forwardToRunning(const QString &location, int timeoutMs)
+{
+    QLocalSocket socket;
+    socket.connectToServer(serverName());
+    if (!socket.waitForConnected(timeoutMs)) {
+        return false;
+    }
+
+    socket.write(location.toUtf8() + '\n');
+    if (!socket.waitForBytesWritten(timeoutMs)) {
+        qWarning() << "Failed to forward request to running instance:" << socket.errorString();
+        return false;
+    }
+
+    socket.disconnectFromServer();
+    if (socket.state() != QLocalSocket::UnconnectedState) {
+        socket.waitForDisconnected(timeoutMs);
+    }
+
+    qDebug() << "Request forwarded to running instance:" << location;
+    return true;
+}
+
+bool SingleInstance::listen()
+{
+    QString name = serverName();
+    m_server->setSocketOptions(QLocalServer::UserAccessOption);
+
+    if (!m_server->listen(name)) {
+        // Сокет остался после аварийного завершения: живой сервер уже ответил бы клиенту
+        qDebug() << "Removing stale instance socket:" << name;
+        QLocalServer::removeServer(name);
+        if (!m_server->listen(name)) {
+            qWarning() << "Single instance server failed:" << m_server->errorString();
+            return false;
+        }
+    }
+
+    qDebug() << "Single instance server listening:" << name;
+    return true;
+}
+
+void SingleInstance::onNewConnection()
+{
+    while (QLocalSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        auto readRequests = [this, socket]() {
+            while (socket->canReadLine()) {
+                QString location = QString::fromUtf8(socket->readLine()).trimmed();
+                qDebug() << "Activation request:" << location;
+                emit activationRequested(location);
+            }
+        };
+        connect(socket, &QLocalSocket::readyRead, this, readRequests);
+        // Короткий запрос мог прийти раньше подключения сигнала
+        readRequests();
+    }
+}
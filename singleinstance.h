@@ -0,0 +1,36 @@
+#ifndef SINGLEINSTANCE_H
+#define SINGLEINSTANCE_H
+
+#include <QObject>
+#include <QString>
+
+class QLocalServer;
+
+// Один экземпляр на пользователя: повторный запуск передаёт запрос
+// работающему окну через локальный сокет и сразу завершается
+class SingleInstance : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SingleInstance(QObject *parent = nullptr);
+
+    // Вызывается до создания QApplication; true - запрос принят работающим экземпляром
+    static bool forwardToRunning(const QString &location, int timeoutMs = 250);
+
+    bool listen();
+
+signals:
+    // Пустой location - просто поднять окно
+    void activationRequested(const QString &location);
+
+private slots:
+    void onNewConnection();
+
+private:
+    static QString serverName();
+
+    QLocalServer *m_server;
+};
+
+#endif // SINGLEINSTANCE_H
@@ -0,0 +1,192 @@
+#include "snapshotaggregator.h"
+#include <QNetworkReply>
+#include <QUrlQuery>
+#include <QJsonDocument>
+#include <QTimer>
+#include <QtMath>
+#include <QDebug>
+
+namespace {
+const char *AIR_QUALITY_API_URL = "http://air-quality-api.open-meteo.com/v1/air-quality";
+const char *MARINE_API_URL = "http://marine-api.open-meteo.com/v1/marine";
+const char *PART_NAMES[] = { "forecast", "air-quality", "marine" };
+
+float currentValue(const QJsonObject &obj, const char *key)
+{
+    QJsonValue value = obj["current"].toObject()[key];
+    return value.isDouble() ? float(value.toDouble()) : float(qQNaN());
+}
+}
+
+SnapshotExtras::SnapshotExtras()
+    : pm25(float(qQNaN()))
+    , usAqi(float(qQNaN()))
+    , waveHeight(float(qQNaN()))
+{
+}
+
+SnapshotAggregator::SnapshotAggregator(RequestScheduler *scheduler, const QString &forecastUrl, QObject *parent)
+    : QObject(parent)
+    , m_scheduler(scheduler)
+    , m_forecastUrl(forecastUrl)
+    , m_nextId(0)
+{
+}
+
+void SnapshotAggregator::request(const QString &location, const GeoPoint &point,
+                                 RequestScheduler::Priority priority, bool extras, int deadlineMs)
+{
+    int id = m_nextId++;
+    Pending &pending = m_pending[id];
+    pending.snapshot.location = location;
+    pending.snapshot.position = point;
+    pending.snapshot.hasForecast = false;
+    pending.snapshot.withExtras = extras;
+    pending.snapshot.timedOut = false;
+    pending.snapshot.latencyMs = 0;
+    pending.remaining = extras ? int(PartCount) : 1;
+    for (int part = 0; part < PartCount; ++part) {
+        pending.tickets[part] = 0;
+    }
+    pending.timer.start();
+
+    // Срок нужен, чтобы медленные воздух и море не задерживали прогноз. Единственный
+    // запрос прогноза ждать незачем: при массовом обновлении избранного он мог бы
+    // истечь ещё в очереди планировщика
+    pending.deadline = nullptr;
+    pending.deadlineMs = extras ? deadlineMs : 0;
+    if (pending.deadlineMs > 0) {
+        pending.deadline = new QTimer(this);
+        pending.deadline->setSingleShot(true);
+        connect(pending.deadline, &QTimer::timeout, this, [this, id]() { finish(id, true); });
+    }
+
+    QUrlQuery base;
+    base.addQueryItem("latitude", QString::number(point.lat));
+    base.addQueryItem("longitude", QString::number(point.lon));
+    base.addQueryItem("timezone", "auto");
+
+    QUrl forecastUrl(m_forecastUrl);
+    QUrlQuery forecastQuery = base;
+    forecastQuery.addQueryItem("current", "temperature_2m,relative_humidity_2m,apparent_temperature,weather_code,wind_speed_10m");
+    forecastQuery.addQueryItem("hourly", "temperature_2m,weather_code");
+    forecastQuery.addQueryItem("forecast_hours", "24");
+    forecastQuery.addQueryItem("daily", "temperature_2m_max,temperature_2m_min,weather_code");
+    forecastQuery.addQueryItem("forecast_days", "16");
+    forecastQuery.addQueryItem("timeformat", "unixtime");
+    forecastUrl.setQuery(forecastQuery);
+
+    QUrl airUrl(AIR_QUALITY_API_URL);
+    QUrlQuery airQuery = base;
+    airQuery.addQueryItem("current", "pm2_5,us_aqi");
+    airUrl.setQuery(airQuery);
+
+    QUrl marineUrl(MARINE_API_URL);
+    QUrlQuery marineQuery = base;
+    marineQuery.addQueryItem("current", "wave_height");
+    marineUrl.setQuery(marineQuery);
+
+    // Все запросы уходят сразу, ответы приходят независимо
+    pending.tickets[Forecast] = startPart(id, Forecast, forecastUrl, location, priority);
+    if (extras) {
+        pending.tickets[AirQuality] = startPart(id, AirQuality, airUrl, location, priority);
+        pending.tickets[Marine] = startPart(id, Marine, marineUrl, location, priority);
+    }
+}
+
+RequestScheduler::Ticket SnapshotAggregator::startPart(int id, Part part, const QUrl &url, const QString &location,
+                                                       RequestScheduler::Priority priority)
+{
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::UserAgentHeader, "SimpleWeather/1.0");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    // Краткий снимок идёт без срока сборки: зависший ответ держал бы город в загрузке
+    request.setTransferTimeout(10000);
+#endif
+
+    return m_scheduler->get(request, priority, location, this,
+                            [this, id, part](QNetworkReply *reply) {
+        onPartFinished(id, part, reply);
+    }, [this, id]() {
+        onPartStarted(id);
+    });
+}
+
+void SnapshotAggregator::onPartStarted(int id)
+{
+    auto it = m_pending.find(id);
+    if (it == m_pending.end()) return;
+
+    // Отсчёт - с первой запущенной части; повтор после вытеснения его не сбрасывает
+    Pending &pending = it.value();
+    if (pending.deadline && !pending.deadline->isActive()) {
+        pending.deadline->start(pending.deadlineMs);
+    }
+}
+
+void SnapshotAggregator::onPartFinished(int id, Part part, QNetworkReply *reply)
+{
+    auto it = m_pending.find(id);
+    if (it == m_pending.end()) return;
+
+    Pending &pending = it.value();
+    LocationSnapshot &snapshot = pending.snapshot;
+    pending.tickets[part] = 0;
+
+    if (reply->error() != QNetworkReply::NoError) {
+        // Морской API отвечает ошибкой для точек вдали от побережья - это не сбой
+        qDebug() << "Snapshot part failed:" << PART_NAMES[part] << snapshot.location << reply->errorString();
+    } else {
+        QJsonObject obj = QJsonDocument::fromJson(reply->readAll()).object();
+        switch (part) {
+        case Forecast:
+            snapshot.forecast = obj;
+            snapshot.hasForecast = !obj["current"].toObject().isEmpty();
+            break;
+        case AirQuality:
+            snapshot.extras.pm25 = currentValue(obj, "pm2_5");
+            snapshot.extras.usAqi = currentValue(obj, "us_aqi");
+            break;
+        case Marine:
+            snapshot.extras.waveHeight = currentValue(obj, "wave_height");
+            break;
+        default:
+            break;
+        }
+    }
+
+    qDebug() << "Snapshot part:" << PART_NAMES[part] << "ms:" << pending.timer.elapsed();
+
+    if (--pending.remaining == 0) {
+        finish(id, false);
+    }
+}
+
+void SnapshotAggregator::finish(int id, bool timedOut)
+{
+    auto it = m_pending.find(id);
+    if (it == m_pending.end()) return;
+
+    Pending pending = it.value();
+    m_pending.erase(it);
+
+    if (pending.deadline) {
+        pending.deadline->stop();
+        pending.deadline->deleteLater();
+    }
+
+    // По сроку: недошедшие части обрываются, снимок уходит частичным
+    for (int part = 0; part < PartCount; ++part) {
+        if (pending.tickets[part]) {
+            qDebug() << "Snapshot part timed out:" << PART_NAMES[part] << pending.snapshot.location;
+            m_scheduler->cancel(pending.tickets[part]);
+        }
+    }
+
+    pending.snapshot.timedOut = timedOut;
+    pending.snapshot.latencyMs = pending.timer.elapsed();
+    qDebug() << "Snapshot ready:" << pending.snapshot.location << "ms:" << pending.snapshot.latencyMs
+             << "timed out:" << timedOut;
+
+    emit snapshotReady(pending.snapshot);
+}
@@ -0,0 +1,76 @@
+#ifndef SNAPSHOTAGGREGATOR_H
+#define SNAPSHOTAGGREGATOR_H
+
+#include <QObject>
+#include <QHash>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include "cityindex.h"
+#include "requestscheduler.h"
+
+class QNetworkReply;
+class QTimer;
+
+// Данные вспомогательных API; NaN - нет данных (вне побережья, не успели к сроку)
+struct SnapshotExtras {
+    float pm25;
+    float usAqi;
+    float waveHeight;
+
+    SnapshotExtras();
+};
+
+struct LocationSnapshot {
+    QString location;
+    GeoPoint position;
+    bool hasForecast;
+    QJsonObject forecast;   // current + сутки по часам + daily в формате Open-Meteo
+    bool withExtras;        // запрашивались ли воздух и море
+    SnapshotExtras extras;
+    bool timedOut;
+    qint64 latencyMs;
+};
+
+// Прогноз, качество воздуха и морские данные запрашиваются параллельно и
+// сводятся в один снимок: готов, когда пришли все ответы или истёк срок.
+// Задержка снимка - самый медленный запрос, а не сумма всех.
+class SnapshotAggregator : public QObject
+{
+    Q_OBJECT
+
+public:
+    SnapshotAggregator(RequestScheduler *scheduler, const QString &forecastUrl, QObject *parent = nullptr);
+
+    // Без extras уходит только запрос прогноза и срока нет. Срок отсчитывается
+    // с запуска первой части, а не с постановки в очередь планировщика
+    void request(const QString &location, const GeoPoint &point, RequestScheduler::Priority priority,
+                 bool extras, int deadlineMs = 4000);
+
+signals:
+    void snapshotReady(const LocationSnapshot &snapshot);
+
+private:
+    enum Part { Forecast, AirQuality, Marine, PartCount };
+
+    struct Pending {
+        LocationSnapshot snapshot;
+        RequestScheduler::Ticket tickets[PartCount];
+        int remaining;
+        QElapsedTimer timer;
+        QTimer *deadline;
+        int deadlineMs;
+    };
+
+    RequestScheduler::Ticket startPart(int id, Part part, const QUrl &url, const QString &location,
+                                       RequestScheduler::Priority priority);
+    void onPartStarted(int id);
+    void onPartFinished(int id, Part part, QNetworkReply *reply);
+    void finish(int id, bool timedOut);
+
+    RequestScheduler *m_scheduler;
+    QString m_forecastUrl;
+    QHash<int, Pending> m_pending;
+    int m_nextId;
+};
+
+#endif // SNAPSHOTAGGREGATOR_H
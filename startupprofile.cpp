@@ -0,0 +1,152 @@
+#include "startupprofile.h"
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QMap>
+#include <QPointer>
+#include <QProcess>
+#include <QStringList>
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+#include <QWidget>
+#include <algorithm>
+
+namespace {
+struct Mark {
+    const char *phase;
+    qint64 nsecs;
+};
+
+QElapsedTimer g_timer;
+QVector<Mark> g_marks;
+bool g_dump = false;
+bool g_exitAfterFirstPaint = false;
+
+const char LINE_PREFIX[] = "startup:";
+
+void dumpMarks()
+{
+    QTextStream err(stderr);
+    qint64 previous = 0;
+    for (const Mark &mark : g_marks) {
+        err << LINE_PREFIX << ' '
+            << QString::number(mark.nsecs / 1000000.0, 'f', 2) << ' '
+            << QString::number((mark.nsecs - previous) / 1000000.0, 'f', 2) << ' '
+            << mark.phase << '\n';
+        previous = mark.nsecs;
+    }
+    err.flush();
+}
+
+// Ловит первое событие отрисовки любого виджета окна и снимает себя
+class FirstPaintFilter : public QObject
+{
+public:
+    explicit FirstPaintFilter(QWidget *window)
+        : QObject(qApp)
+        , m_window(window)
+    {
+    }
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        if (event->type() == QEvent::Paint && watched->isWidgetType() && m_window
+                && static_cast<QWidget*>(watched)->window() == m_window) {
+            StartupProfile::mark("first_paint");
+            qApp->removeEventFilter(this);
+
+            if (g_dump) {
+                dumpMarks();
+            }
+            if (g_exitAfterFirstPaint) {
+                QTimer::singleShot(0, qApp, &QCoreApplication::quit);
+            }
+            deleteLater();
+        }
+        return false;
+    }
+
+private:
+    QPointer<QWidget> m_window;
+};
+}
+
+void StartupProfile::start()
+{
+    g_timer.start();
+    g_marks.reserve(32);
+    mark("main");
+}
+
+void StartupProfile::mark(const char *phase)
+{
+    if (!g_timer.isValid()) return;
+
+    Mark mark;
+    mark.phase = phase;
+    mark.nsecs = g_timer.nsecsElapsed();
+    g_marks.append(mark);
+}
+
+void StartupProfile::configure(bool dump, bool exitAfterFirstPaint)
+{
+    g_dump = dump;
+    g_exitAfterFirstPaint = exitAfterFirstPaint;
+}
+
+void StartupProfile::watchFirstPaint(QWidget *window)
+{
+    qApp->installEventFilter(new FirstPaintFilter(window));
+}
+
+int runStartupBenchmark(int runs)
+{
+    QTextStream out(stdout);
+    runs = qMax(runs, 1);
+
+    // Фаза -> длительности по запускам; порядок фаз - как в первом запуске
+    QMap<QString, QVector<double>> deltas;
+    QVector<double> totals;
+    QStringList order;
+
+    for (int run = 0; run < runs; ++run) {
+        QProcess child;
+        child.start(QCoreApplication::applicationFilePath(),
+                    QStringList() << "--startup-profile" << "--startup-exit" << "--new-instance");
+        if (!child.waitForFinished(30000)) {
+            out << "run " << run + 1 << ": child did not finish, skipping\n";
+            child.kill();
+            child.waitForFinished();
+            continue;
+        }
+
+        const QList<QByteArray> lines = child.readAllStandardError().split('\n');
+        for (const QByteArray &line : lines) {
+            if (!line.startsWith(LINE_PREFIX)) continue;
+
+            const QList<QByteArray> fields = line.mid(int(sizeof(LINE_PREFIX)) - 1).trimmed().split(' ');
+            if (fields.size() < 3) continue;
+
+            QString phase = QString::fromLatin1(fields[2]);
+            if (!deltas.contains(phase)) order << phase;
+            deltas[phase].append(fields[1].toDouble());
+            if (phase == "first_paint") totals.append(fields[0].toDouble());
+        }
+    }
+
+    auto median = [](QVector<double> values) {
+        if (values.isEmpty()) return 0.0;
+        std::sort(values.begin(), values.end());
+        return values[values.size() / 2];
+    };
+
+    out << "Startup phases, median of " << totals.size() << " runs (ms):\n";
+    for (const QString &phase : order) {
+        out << "  " << phase.leftJustified(16) << QString::number(median(deltas[phase]), 'f', 2) << "\n";
+    }
+    out << "  " << QString("total").leftJustified(16) << QString::number(median(totals), 'f', 2) << "\n";
+
+    return totals.isEmpty() ? 1 : 0;
+}
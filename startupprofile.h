@@ -0,0 +1,24 @@
+#ifndef STARTUPPROFILE_H
+#define STARTUPPROFILE_H
+
+class QWidget;
+
+// Отметки фаз запуска от входа в main() до первой отрисовки окна.
+// Отметки пишутся всегда (это одно чтение таймера), печатаются по --startup-profile.
+class StartupProfile
+{
+public:
+    static void start();
+    static void mark(const char *phase);
+
+    // dump - напечатать фазы в stderr после первой отрисовки,
+    // exitAfterFirstPaint - сразу завершить приложение (для замеров)
+    static void configure(bool dump, bool exitAfterFirstPaint);
+    static void watchFirstPaint(QWidget *window);
+};
+
+// Медианы фаз по нескольким холодным запускам дочерних процессов.
+// Запуск: SimpleWeather --bench-startup 10 или make startup-bench
+int runStartupBenchmark(int runs);
+
+#endif // STARTUPPROFILE_H
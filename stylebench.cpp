@@ -0,0 +1,149 @@
+#include "stylebench.h"
+#include "themeengine.h"
+#include "forecastdayrow.h"
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QLabel>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+
+namespace {
+const int ROUNDS = 21;
+
+// Правила прежнего applyTheme, которые касаются строк прогноза
+const char *LEGACY_STYLESHEET = R"(
+    QWidget {
+        background-color: #0d0d0d;
+        color: #ffffff;
+    }
+    QLabel {
+        color: #ffffff;
+        background-color: transparent;
+    }
+    QFrame {
+        background-color: #1a1a1a;
+        color: #ffffff;
+        border: 1px solid #2d2d2d;
+        border-radius: 8px;
+    }
+    QFrame#weatherFrame, QFrame#favoritesFrame {
+        background-color: #1a1a1a;
+        border: 1px solid #2d2d2d;
+    }
+    QPushButton {
+        background-color: #0d7377;
+        color: #ffffff;
+        border: none;
+        border-radius: 4px;
+        padding: 8px 16px;
+        font-weight: bold;
+    }
+    QScrollArea {
+        background-color: #0d0d0d;
+        border: none;
+    }
+    QScrollArea > QWidget > QWidget {
+        background-color: #0d0d0d;
+    }
+)";
+
+struct Sample {
+    double buildMs;
+    double polishMs;
+};
+
+QLabel *label(const QString &text, int pointSize, bool bold = false)
+{
+    QLabel *result = new QLabel(text);
+    QFont font = result->font();
+    font.setPointSize(pointSize);
+    font.setBold(bold);
+    result->setFont(font);
+    return result;
+}
+
+// Те же строки, что строит MainWindow::displayForecast
+Sample buildRows(int rows, bool styleSheet)
+{
+    QWidget container;
+    if (styleSheet) {
+        container.setStyleSheet(QString::fromLatin1(LEGACY_STYLESHEET));
+    }
+    QVBoxLayout *layout = new QVBoxLayout(&container);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < rows; ++i) {
+        ForecastDayRow *row = new ForecastDayRow(qint64(i) * 86400);
+        QHBoxLayout *dayLayout = row->summaryLayout();
+        QLabel *dateLabel = label(QString("Day %1").arg(i + 1), 12);
+        dateLabel->setMinimumWidth(120);
+        dayLayout->addWidget(dateLabel);
+        dayLayout->addWidget(new QLabel());
+        QLabel *descLabel = label("Partly cloudy", 12);
+        descLabel->setMinimumWidth(90);
+        dayLayout->addWidget(descLabel);
+        dayLayout->addStretch();
+        dayLayout->addWidget(label("18°C / 9°C", 13, true));
+        layout->addWidget(row);
+    }
+    layout->addStretch();
+    qint64 built = timer.nsecsElapsed();
+
+    container.ensurePolished();
+    for (int i = 0; i < layout->count(); ++i) {
+        if (QWidget *row = layout->itemAt(i)->widget()) {
+            row->ensurePolished();
+            const QList<QWidget*> children = row->findChildren<QWidget*>();
+            for (QWidget *child : children) {
+                child->ensurePolished();
+            }
+        }
+    }
+    layout->activate();
+
+    Sample sample;
+    sample.buildMs = built / 1000000.0;
+    sample.polishMs = (timer.nsecsElapsed() - built) / 1000000.0;
+    return sample;
+}
+
+double median(QVector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+void report(const char *name, int rows, bool styleSheet, QTextStream &out)
+{
+    // Первый проход прогревает шрифты и кеши стиля и в медиану не входит
+    buildRows(rows, styleSheet);
+
+    QVector<double> build;
+    QVector<double> polish;
+    for (int round = 0; round < ROUNDS; ++round) {
+        Sample sample = buildRows(rows, styleSheet);
+        build.append(sample.buildMs);
+        polish.append(sample.polishMs);
+    }
+    out << "  " << QString(name).leftJustified(14)
+        << "build " << QString::number(median(build), 'f', 2) << " ms, "
+        << "polish+layout " << QString::number(median(polish), 'f', 2) << " ms\n";
+    out.flush();
+}
+}
+
+int runStyleBenchmark(int rows)
+{
+    QTextStream out(stdout);
+    rows = qMax(rows, 1);
+    ThemeEngine::apply(ThemeEngine::Dark);
+
+    out << rows << " forecast rows, median of " << ROUNDS << " rounds:\n";
+    report("stylesheet", rows, true, out);
+    report("theme engine", rows, false, out);
+    return 0;
+}
@@ -0,0 +1,8 @@
+#ifndef STYLEBENCH_H
+#define STYLEBENCH_H
+
+// Полировка и раскладка строк прогноза: прежняя таблица стилей против
+// палитры и WeatherStyle. Запуск: SimpleWeather --bench-style 16 или make style-bench
+int runStyleBenchmark(int rows);
+
+#endif // STYLEBENCH_H
@@ -0,0 +1,237 @@
+#include "suggestionprefetcher.h"
+#include <QNetworkReply>
+#include <QUrlQuery>
+#include <QJsonDocument>
+#include <QDateTime>
+#include <QSet>
+#include <QDebug>
+
+namespace {
+const int MAX_CANDIDATES = 2;
+const int MAX_IN_FLIGHT = 2;
+const int MAX_REQUESTS_PER_MINUTE = 10;
+const int MAX_ENTRIES = 6;
+const qint64 ENTRY_TTL_MS = 5 * 60 * 1000;
+}
+
+SuggestionPrefetcher::SuggestionPrefetcher(RequestScheduler *scheduler, const QString &apiUrl, QObject *parent)
+    : QObject(parent)
+    , m_scheduler(scheduler)
+    , m_apiUrl(apiUrl)
+{
+    m_stats.issued = 0;
+    m_stats.hits = 0;
+    m_stats.pendingHits = 0;
+    m_stats.misses = 0;
+    m_stats.wasted = 0;
+    m_stats.skippedByBudget = 0;
+}
+
+SuggestionPrefetcher::~SuggestionPrefetcher()
+{
+    const QStringList cities = m_entries.keys();
+    for (const QString &city : cities) {
+        dropEntry(city, false);
+    }
+    logStats();
+}
+
+void SuggestionPrefetcher::prefetch(const QList<PrefetchCandidate> &candidates)
+{
+    expireEntries();
+
+    QList<PrefetchCandidate> top = candidates.mid(0, MAX_CANDIDATES);
+    QSet<QString> wanted;
+    for (const PrefetchCandidate &candidate : top) {
+        wanted.insert(candidate.city);
+    }
+
+    // Подсказки сменились: запросы для ушедших городов больше не нужны
+    int inFlight = 0;
+    const QStringList cities = m_entries.keys();
+    for (const QString &city : cities) {
+        if (!m_entries[city].ticket) continue;
+        if (wanted.contains(city) || city == m_awaited) {
+            ++inFlight;
+        } else {
+            dropEntry(city, false);
+        }
+    }
+
+    for (const PrefetchCandidate &candidate : top) {
+        if (m_entries.contains(candidate.city)) continue;
+        if (inFlight >= MAX_IN_FLIGHT) break;
+        if (!takeBudget()) {
+            ++m_stats.skippedByBudget;
+            break;
+        }
+
+        QUrl url(m_apiUrl);
+        QUrlQuery query;
+        query.addQueryItem("latitude", QString::number(candidate.position.lat));
+        query.addQueryItem("longitude", QString::number(candidate.position.lon));
+        // Тот же состав, что у краткого запроса WeatherService: ответ сразу идёт в его кэш
+        query.addQueryItem("current", "temperature_2m,relative_humidity_2m,apparent_temperature,weather_code,wind_speed_10m");
+        query.addQueryItem("hourly", "temperature_2m,weather_code");
+        query.addQueryItem("forecast_hours", "24");
+        query.addQueryItem("daily", "temperature_2m_max,temperature_2m_min,weather_code");
+        query.addQueryItem("forecast_days", "16");
+        query.addQueryItem("timezone", "auto");
+        query.addQueryItem("timeformat", "unixtime");
+        url.setQuery(query);
+
+        QNetworkRequest request(url);
+        request.setHeader(QNetworkRequest::UserAgentHeader, "SimpleWeather/1.0");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+        request.setTransferTimeout(10000);
+#endif
+
+        QString city = candidate.city;
+        Entry entry;
+        entry.position = candidate.position;
+        entry.fetchedAt = 0;
+        // Упреждающие запросы - самый низкий класс: уступают поиску и избранному
+        entry.ticket = m_scheduler->get(request, RequestScheduler::Prefetch, city, this,
+                                        [this, city](QNetworkReply *reply) {
+            onReplyFinished(city, reply);
+        });
+        m_entries.insert(city, entry);
+        ++m_stats.issued;
+        ++inFlight;
+
+        qDebug() << "Prefetching weather for suggestion:" << city;
+    }
+
+    // Кэш ограничен: лишние готовые ответы выбрасываются, начиная со старых
+    while (m_entries.size() > MAX_ENTRIES) {
+        QString oldest;
+        qint64 oldestAt = 0;
+        for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+            if (it.value().ticket) continue;
+            if (oldest.isEmpty() || it.value().fetchedAt < oldestAt) {
+                oldest = it.key();
+                oldestAt = it.value().fetchedAt;
+            }
+        }
+        if (oldest.isEmpty()) break;
+        dropEntry(oldest, false);
+    }
+}
+
+SuggestionPrefetcher::Lookup SuggestionPrefetcher::lookup(const QString &city, QJsonObject *response,
+                                                          GeoPoint *position)
+{
+    expireEntries();
+
+    auto it = m_entries.find(city);
+    if (it == m_entries.end()) {
+        ++m_stats.misses;
+        m_awaited.clear();
+        logStats();
+        return Miss;
+    }
+
+    *position = it.value().position;
+    if (it.value().ticket) {
+        ++m_stats.pendingHits;
+        m_awaited = city;
+        // Теперь ответа ждёт пользователь: фоновый запрос не должен стоять за избранным и картой
+        m_scheduler->raise(it.value().ticket, RequestScheduler::Interactive);
+        logStats();
+        return Pending;
+    }
+
+    *response = it.value().response;
+    ++m_stats.hits;
+    m_awaited.clear();
+    dropEntry(city, true);
+    logStats();
+    return Ready;
+}
+
+void SuggestionPrefetcher::logStats() const
+{
+    int lookups = m_stats.hits + m_stats.pendingHits + m_stats.misses;
+    double hitRate = lookups > 0 ? 100.0 * (m_stats.hits + m_stats.pendingHits) / lookups : 0.0;
+
+    qDebug() << "Prefetch stats: issued" << m_stats.issued
+             << "hits" << m_stats.hits << "in-flight hits" << m_stats.pendingHits
+             << "misses" << m_stats.misses << "wasted" << m_stats.wasted
+             << "over budget" << m_stats.skippedByBudget
+             << "hit rate %" << hitRate;
+}
+
+bool SuggestionPrefetcher::takeBudget()
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    while (!m_recentRequests.isEmpty() && now - m_recentRequests.head() > 60000) {
+        m_recentRequests.dequeue();
+    }
+    if (m_recentRequests.size() >= MAX_REQUESTS_PER_MINUTE) {
+        return false;
+    }
+    m_recentRequests.enqueue(now);
+    return true;
+}
+
+void SuggestionPrefetcher::onReplyFinished(const QString &city, QNetworkReply *reply)
+{
+    // Выброшенная запись отменяет свой запрос - колбэк приходит только для живой
+    auto it = m_entries.find(city);
+    if (it == m_entries.end() || !it.value().ticket) return;
+
+    it.value().ticket = 0;
+
+    if (reply->error() != QNetworkReply::NoError) {
+        qDebug() << "Prefetch error:" << city << reply->errorString();
+        bool awaited = (city == m_awaited);
+        GeoPoint position = it.value().position;
+        dropEntry(city, false);
+        if (awaited) {
+            // Ждавший ответа пользователь получит обычную загрузку по известным координатам
+            m_awaited.clear();
+            emit awaitedReady(city, QJsonObject(), position);
+        }
+        return;
+    }
+
+    it.value().response = QJsonDocument::fromJson(reply->readAll()).object();
+    it.value().fetchedAt = QDateTime::currentMSecsSinceEpoch();
+
+    if (city == m_awaited) {
+        m_awaited.clear();
+        QJsonObject response = it.value().response;
+        GeoPoint position = it.value().position;
+        dropEntry(city, true);
+        emit awaitedReady(city, response, position);
+    }
+}
+
+void SuggestionPrefetcher::dropEntry(const QString &city, bool used)
+{
+    auto it = m_entries.find(city);
+    if (it == m_entries.end()) return;
+
+    RequestScheduler::Ticket ticket = it.value().ticket;
+    m_entries.erase(it);
+
+    if (!used) {
+        ++m_stats.wasted;
+    }
+    // Отменённый запрос колбэк уже не вызовет
+    if (ticket) {
+        m_scheduler->cancel(ticket);
+    }
+}
+
+void SuggestionPrefetcher::expireEntries()
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const QStringList cities = m_entries.keys();
+    for (const QString &city : cities) {
+        const Entry &entry = m_entries[city];
+        if (!entry.ticket && now - entry.fetchedAt > ENTRY_TTL_MS) {
+            dropEntry(city, false);
+        }
+    }
+}
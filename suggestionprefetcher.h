@@ -0,0 +1,75 @@
+#ifndef SUGGESTIONPREFETCHER_H
+#define SUGGESTIONPREFETCHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QQueue>
+#include <QJsonObject>
+#include "cityindex.h"
+#include "requestscheduler.h"
+
+class QNetworkReply;
+
+struct PrefetchCandidate {
+    QString city;
+    GeoPoint position;
+};
+
+// Упреждающая загрузка погоды для первых подсказок автодополнения.
+// Один совмещённый запрос (current + сутки по часам + daily) на город, жёсткий бюджет запросов,
+// ответы живут ограниченное время. Попадания и впустую потраченные запросы считаются.
+class SuggestionPrefetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Lookup {
+        Miss,
+        Ready,   // ответ уже в кэше
+        Pending  // запрос в пути, результат придёт сигналом awaitedReady
+    };
+
+    struct Stats {
+        int issued;
+        int hits;
+        int pendingHits;
+        int misses;
+        int wasted;
+        int skippedByBudget;
+    };
+
+    SuggestionPrefetcher(RequestScheduler *scheduler, const QString &apiUrl, QObject *parent = nullptr);
+    ~SuggestionPrefetcher();
+
+    void prefetch(const QList<PrefetchCandidate> &candidates);
+    Lookup lookup(const QString &city, QJsonObject *response, GeoPoint *position);
+
+    Stats stats() const { return m_stats; }
+    void logStats() const;
+
+signals:
+    void awaitedReady(const QString &city, const QJsonObject &response, const GeoPoint &position);
+
+private:
+    struct Entry {
+        GeoPoint position;
+        // 0 после завершения
+        RequestScheduler::Ticket ticket;
+        QJsonObject response;
+        qint64 fetchedAt;
+    };
+
+    bool takeBudget();
+    void onReplyFinished(const QString &city, QNetworkReply *reply);
+    void dropEntry(const QString &city, bool used);
+    void expireEntries();
+
+    RequestScheduler *m_scheduler;
+    QString m_apiUrl;
+    QHash<QString, Entry> m_entries;
+    QQueue<qint64> m_recentRequests;
+    QString m_awaited;
+    Stats m_stats;
+};
+
+#endif // SUGGESTIONPREFETCHER_H
@@ -0,0 +1,181 @@
+#include "themeengine.h"
+#include <QApplication>
+#include <QStyleFactory>
+#include <QStyleOption>
+#include <QPainter>
+#include <QPushButton>
+#include <QComboBox>
+
+namespace {
+const qreal FRAME_RADIUS = 8.0;
+const qreal CONTROL_RADIUS = 4.0;
+
+QRectF alignedRect(const QRect &rect)
+{
+    // Сдвиг на полпикселя, чтобы линия толщиной 1 не размывалась
+    return QRectF(rect).adjusted(0.5, 0.5, -0.5, -0.5);
+}
+}
+
+WeatherStyle::WeatherStyle()
+    : QProxyStyle(QStyleFactory::create("Fusion"))
+{
+}
+
+void WeatherStyle::polish(QWidget *widget)
+{
+    QProxyStyle::polish(widget);
+
+    if (qobject_cast<QPushButton*>(widget) || qobject_cast<QComboBox*>(widget)) {
+        widget->setAttribute(Qt::WA_Hover, true);
+    }
+
+    if (qobject_cast<QPushButton*>(widget)) {
+        QFont font = widget->font();
+        font.setBold(true);
+        widget->setFont(font);
+    }
+}
+
+void WeatherStyle::unpolish(QWidget *widget)
+{
+    if (qobject_cast<QPushButton*>(widget) || qobject_cast<QComboBox*>(widget)) {
+        widget->setAttribute(Qt::WA_Hover, false);
+    }
+
+    QProxyStyle::unpolish(widget);
+}
+
+void WeatherStyle::drawPrimitive(PrimitiveElement element, const QStyleOption *option,
+                                 QPainter *painter, const QWidget *widget) const
+{
+    const QPalette &pal = option->palette;
+
+    switch (element) {
+    case PE_Frame:
+    case PE_FrameGroupBox: {
+        painter->save();
+        painter->setRenderHint(QPainter::Antialiasing, true);
+        painter->setPen(QPen(pal.color(QPalette::Mid), 1));
+        painter->setBrush(pal.color(QPalette::AlternateBase));
+        painter->drawRoundedRect(alignedRect(option->rect), FRAME_RADIUS, FRAME_RADIUS);
+        painter->restore();
+        return;
+    }
+    case PE_PanelLineEdit: {
+        bool focused = option->state & State_HasFocus;
+        painter->save();
+        painter->setRenderHint(QPainter::Antialiasing, true);
+        painter->setPen(QPen(pal.color(focused ? QPalette::Highlight : QPalette::Dark), 1));
+        painter->setBrush(pal.color(QPalette::Base));
+        painter->drawRoundedRect(alignedRect(option->rect), CONTROL_RADIUS, CONTROL_RADIUS);
+        painter->restore();
+        return;
+    }
+    case PE_FrameLineEdit:
+        // Рамка уже нарисована вместе с панелью
+        return;
+    case PE_PanelButtonCommand: {
+        bool hovered = (option->state & State_MouseOver) && (option->state & State_Enabled);
+        bool pressed = option->state & (State_Sunken | State_On);
+
+        painter->save();
+        painter->setRenderHint(QPainter::Antialiasing, true);
+
+        if (qobject_cast<const QComboBox*>(widget)) {
+            // Выпадающий список оформлен как поле ввода, а не как кнопка
+            painter->setPen(QPen(pal.color(hovered ? QPalette::Highlight : QPalette::Dark), 1));
+            painter->setBrush(pal.color(QPalette::Base));
+        } else {
+            QColor color = pal.color(QPalette::Button);
+            if (!(option->state & State_Enabled)) color = color.darker(150);
+            else if (pressed) color = color.darker(130);
+            else if (hovered) color = color.lighter(130);
+            painter->setPen(Qt::NoPen);
+            painter->setBrush(color);
+        }
+
+        painter->drawRoundedRect(alignedRect(option->rect), CONTROL_RADIUS, CONTROL_RADIUS);
+        painter->restore();
+        return;
+    }
+    case PE_FrameFocusRect:
+        if (qobject_cast<const QPushButton*>(widget)) return;
+        break;
+    default:
+        break;
+    }
+
+    QProxyStyle::drawPrimitive(element, option, painter, widget);
+}
+
+int WeatherStyle::pixelMetric(PixelMetric metric, const QStyleOption *option,
+                              const QWidget *widget) const
+{
+    switch (metric) {
+    case PM_ButtonShiftHorizontal:
+    case PM_ButtonShiftVertical:
+        return 0;
+    default:
+        return QProxyStyle::pixelMetric(metric, option, widget);
+    }
+}
+
+void ThemeEngine::apply(Theme theme)
+{
+    // Стиль устанавливается один раз, дальше меняется только палитра
+    if (!qobject_cast<WeatherStyle*>(QApplication::style())) {
+        QApplication::setStyle(new WeatherStyle);
+    }
+    QApplication::setPalette(palette(theme));
+}
+
+QPalette ThemeEngine::palette(Theme theme)
+{
+    QPalette pal;
+
+    if (theme == Dark) {
+        pal.setColor(QPalette::Window, QColor("#0d0d0d"));
+        pal.setColor(QPalette::WindowText, QColor("#ffffff"));
+        pal.setColor(QPalette::Base, QColor("#2d2d2d"));
+        pal.setColor(QPalette::AlternateBase, QColor("#1a1a1a"));
+        pal.setColor(QPalette::Text, QColor("#ffffff"));
+        pal.setColor(QPalette::ToolTipBase, QColor("#1a1a1a"));
+        pal.setColor(QPalette::ToolTipText, QColor("#ffffff"));
+        pal.setColor(QPalette::Mid, QColor("#2d2d2d"));
+        pal.setColor(QPalette::Dark, QColor("#404040"));
+        pal.setColor(QPalette::Light, QColor("#505050"));
+    } else {
+        pal.setColor(QPalette::Window, QColor("#f2f3f5"));
+        pal.setColor(QPalette::WindowText, QColor("#1a1a1a"));
+        pal.setColor(QPalette::Base, QColor("#ffffff"));
+        pal.setColor(QPalette::AlternateBase, QColor("#ffffff"));
+        pal.setColor(QPalette::Text, QColor("#1a1a1a"));
+        pal.setColor(QPalette::ToolTipBase, QColor("#ffffff"));
+        pal.setColor(QPalette::ToolTipText, QColor("#1a1a1a"));
+        pal.setColor(QPalette::Mid, QColor("#d5d8dc"));
+        pal.setColor(QPalette::Dark, QColor("#b0b4ba"));
+        pal.setColor(QPalette::Light, QColor("#e6e8eb"));
+    }
+
+    // Акцентный цвет общий для обеих тем
+    pal.setColor(QPalette::Button, QColor("#0d7377"));
+    pal.setColor(QPalette::ButtonText, QColor("#ffffff"));
+    pal.setColor(QPalette::Highlight, QColor("#0d7377"));
+    pal.setColor(QPalette::HighlightedText, QColor("#ffffff"));
+    pal.setColor(QPalette::Disabled, QPalette::Text, QColor("#808080"));
+    pal.setColor(QPalette::Disabled, QPalette::WindowText, QColor("#808080"));
+    pal.setColor(QPalette::Disabled, QPalette::ButtonText, QColor("#a0a0a0"));
+
+    return pal;
+}
+
+ThemeEngine::Theme ThemeEngine::fromString(const QString &name)
+{
+    return name == "light" ? Light : Dark;
+}
+
+QString ThemeEngine::toString(Theme theme)
+{
+    return theme == Light ? "light" : "dark";
+}
@@ -0,0 +1,42 @@
+#ifndef THEMEENGINE_H
+#define THEMEENGINE_H
+
+#include <QProxyStyle>
+#include <QPalette>
+
+// Стиль приложения: скруглённые рамки, поля ввода и кнопки рисуются нативно
+// по цветам палитры, без движка таблиц стилей
+class WeatherStyle : public QProxyStyle
+{
+    Q_OBJECT
+
+public:
+    WeatherStyle();
+
+    using QProxyStyle::polish;
+    using QProxyStyle::unpolish;
+    void polish(QWidget *widget) override;
+    void unpolish(QWidget *widget) override;
+    void drawPrimitive(PrimitiveElement element, const QStyleOption *option,
+                       QPainter *painter, const QWidget *widget = nullptr) const override;
+    int pixelMetric(PixelMetric metric, const QStyleOption *option = nullptr,
+                    const QWidget *widget = nullptr) const override;
+};
+
+class ThemeEngine
+{
+public:
+    enum Theme {
+        Dark,
+        Light
+    };
+
+    // Переключение темы меняет только палитру: виджеты не переполируются
+    static void apply(Theme theme);
+    static QPalette palette(Theme theme);
+
+    static Theme fromString(const QString &name);
+    static QString toString(Theme theme);
+};
+
+#endif // THEMEENGINE_H
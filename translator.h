@@ -3,7 +3,7 @@
 
 #include <QString>
 #include <QSettings>
-#include <QMap>
+#include <QHash>
 #include <QFile>
 #include <QDir>
 
@@ -23,6 +23,8 @@ private:
 
     QString m_currentLang;
     QSettings *m_translations;
+    // Разобранные языки: второй появляется только после первого переключения
+    QHash<QString, QSettings*> m_loaded;
 };
 
 // Удобный макрос для переводов
@@ -0,0 +1,97 @@
+#include "weathericons.h"
+#include <QSvgRenderer>
+#include <QPainter>
+#include <QImage>
+#include <QDebug>
+#include <QtMath>
+
+WeatherIconAtlas& WeatherIconAtlas::instance()
+{
+    static WeatherIconAtlas inst;
+    return inst;
+}
+
+WeatherIconAtlas::WeatherIconAtlas()
+{
+}
+
+WeatherIconAtlas::Condition WeatherIconAtlas::conditionForCode(int weatherCode)
+{
+    // Те же диапазоны кодов WMO, что и в описаниях погоды
+    if (weatherCode == 0) return Clear;
+    else if (weatherCode <= 3) return Cloudy;
+    else if (weatherCode <= 67) return Rain;
+    else if (weatherCode <= 77) return Snow;
+    else return Thunderstorm;
+}
+
+QString WeatherIconAtlas::iconPath(Condition condition)
+{
+    switch (condition) {
+    case Cloudy: return ":/res/icons/cloudy.svg";
+    case Rain: return ":/res/icons/rain.svg";
+    case Snow: return ":/res/icons/snow.svg";
+    case Thunderstorm: return ":/res/icons/thunderstorm.svg";
+    default: return ":/res/icons/clear.svg";
+    }
+}
+
+const WeatherIconAtlas::Atlas &WeatherIconAtlas::atlas(int size, qreal devicePixelRatio)
+{
+    int dprKey = qRound(devicePixelRatio * 100);
+    quint64 key = (quint64(size) << 32) | quint32(dprKey);
+
+    auto it = m_atlases.constFind(key);
+    if (it != m_atlases.constEnd()) {
+        return it.value();
+    }
+
+    // Все иконки одного размера лежат в одной полосе
+    int pixels = qCeil(size * devicePixelRatio);
+    QImage sheet(pixels * ConditionCount, pixels, QImage::Format_ARGB32_Premultiplied);
+    sheet.fill(Qt::transparent);
+
+    QPainter painter(&sheet);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    for (int i = 0; i < ConditionCount; ++i) {
+        QSvgRenderer renderer(iconPath(static_cast<Condition>(i)));
+        if (!renderer.isValid()) {
+            qWarning() << "Weather icon not found:" << iconPath(static_cast<Condition>(i));
+            continue;
+        }
+        renderer.render(&painter, QRectF(i * pixels, 0, pixels, pixels));
+    }
+    painter.end();
+
+    Atlas atlas;
+    atlas.sheet = QPixmap::fromImage(sheet);
+    atlas.sheet.setDevicePixelRatio(devicePixelRatio);
+    for (int i = 0; i < ConditionCount; ++i) {
+        QPixmap icon = atlas.sheet.copy(i * pixels, 0, pixels, pixels);
+        icon.setDevicePixelRatio(devicePixelRatio);
+        atlas.icons.append(icon);
+    }
+
+    qDebug() << "Weather icon atlas rasterized, size:" << size << "dpr:" << devicePixelRatio;
+
+    return m_atlases.insert(key, atlas).value();
+}
+
+QPixmap WeatherIconAtlas::icon(Condition condition, int size, qreal devicePixelRatio)
+{
+    return atlas(size, devicePixelRatio).icons.value(condition);
+}
+
+void WeatherIconAtlas::draw(QPainter *painter, const QRect &target, Condition condition)
+{
+    qreal dpr = painter->device() ? painter->device()->devicePixelRatioF() : 1.0;
+    const Atlas &sheet = atlas(qMin(target.width(), target.height()), dpr);
+
+    int pixels = sheet.sheet.height();
+    painter->drawPixmap(target, sheet.sheet, QRect(condition * pixels, 0, pixels, pixels));
+}
+
+void WeatherIconAtlas::clear()
+{
+    m_atlases.clear();
+}
@@ -0,0 +1,47 @@
+#ifndef WEATHERICONS_H
+#define WEATHERICONS_H
+
+#include <QPixmap>
+#include <QVector>
+#include <QHash>
+
+class QPainter;
+
+// Атлас иконок погоды: набор SVG растеризуется один раз для каждой пары
+// (размер, devicePixelRatio), дальше иконки только копируются из атласа
+class WeatherIconAtlas
+{
+public:
+    enum Condition {
+        Clear,
+        Cloudy,
+        Rain,
+        Snow,
+        Thunderstorm,
+        ConditionCount
+    };
+
+    static WeatherIconAtlas& instance();
+    static Condition conditionForCode(int weatherCode);
+
+    QPixmap icon(Condition condition, int size, qreal devicePixelRatio);
+    void draw(QPainter *painter, const QRect &target, Condition condition);
+    void clear();
+
+private:
+    WeatherIconAtlas();
+    WeatherIconAtlas(const WeatherIconAtlas&) = delete;
+    WeatherIconAtlas& operator=(const WeatherIconAtlas&) = delete;
+
+    struct Atlas {
+        QPixmap sheet;
+        QVector<QPixmap> icons;
+    };
+
+    const Atlas &atlas(int size, qreal devicePixelRatio);
+    static QString iconPath(Condition condition);
+
+    QHash<quint64, Atlas> m_atlases;
+};
+
+#endif // WEATHERICONS_H
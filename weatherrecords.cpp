@@ -0,0 +1,22 @@
+#include "weatherrecords.h"
+
+quint32 LocationTable::intern(const QString &name)
+{
+    auto it = m_ids.constFind(name);
+    if (it != m_ids.constEnd()) return it.value();
+
+    quint32 id = quint32(m_names.size());
+    m_names.append(name);
+    m_ids.insert(name, id);
+    return id;
+}
+
+quint32 LocationTable::find(const QString &name) const
+{
+    return m_ids.value(name, InvalidId);
+}
+
+QString LocationTable::name(quint32 id) const
+{
+    return id < quint32(m_names.size()) ? m_names[int(id)] : QString();
+}
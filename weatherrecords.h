@@ -0,0 +1,51 @@
+#ifndef WEATHERRECORDS_H
+#define WEATHERRECORDS_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QHash>
+#include <QVector>
+
+// Компактные записи погоды: только числа и код погоды в байте.
+// Город хранится идентификатором из LocationTable, описание и иконка
+// выводятся из weatherCode при отрисовке.
+
+struct WeatherData {
+    qint64 time;            // секунды эпохи
+    float temp;
+    float feelsLike;
+    float windSpeed;
+    quint32 locationId;
+    quint8 humidity;
+    quint8 weatherCode;
+};
+
+// Одна точка прогноза (день или час). time - местная полночь/час места,
+// записанные как UTC: при отрисовке время форматируется в Qt::UTC
+struct ForecastData {
+    qint64 time;
+    float tempMin;
+    float tempMax;
+    quint8 weatherCode;
+};
+
+Q_STATIC_ASSERT(sizeof(WeatherData) <= 32);
+Q_STATIC_ASSERT(sizeof(ForecastData) <= 24);
+
+// Интернирование названий мест: каждое название хранится один раз
+class LocationTable
+{
+public:
+    static const quint32 InvalidId = 0xffffffffu;
+
+    quint32 intern(const QString &name);
+    quint32 find(const QString &name) const;
+    QString name(quint32 id) const;
+    int size() const { return m_names.size(); }
+
+private:
+    QHash<QString, quint32> m_ids;
+    QVector<QString> m_names;
+};
+
+#endif // WEATHERRECORDS_H
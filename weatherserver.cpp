@@ -0,0 +1,267 @@
+#include "weatherserver.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUrlQuery>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QDateTime>
+#include <QTimer>
+#include <QDebug>
+
+namespace {
+const int FORECAST_DAYS = 5;
+const int MAX_CONNECTIONS = 1024;
+const int MAX_REQUEST_SIZE = 8192;
+const int CLIENT_TIMEOUT_MS = 10000;
+
+const char *reasonPhrase(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    default: return "Error";
+    }
+}
+
+QByteArray errorBody(const QString &message)
+{
+    QJsonObject obj;
+    obj["error"] = message;
+    return QJsonDocument(obj).toJson(QJsonDocument::Compact);
+}
+}
+
+WeatherServer::WeatherServer(WeatherService *service, QObject *parent)
+    : QObject(parent)
+    , m_server(new QTcpServer(this))
+    , m_service(service)
+    , m_requests(0)
+    , m_openConnections(0)
+{
+    connect(m_server, &QTcpServer::newConnection, this, &WeatherServer::onNewConnection);
+}
+
+bool WeatherServer::listen(quint16 port, const QHostAddress &address)
+{
+    if (!m_server->listen(address, port)) {
+        qWarning() << "Weather server failed to listen:" << m_server->errorString();
+        return false;
+    }
+    qDebug() << "Weather server listening on" << m_server->serverAddress() << m_server->serverPort();
+    return true;
+}
+
+quint16 WeatherServer::serverPort() const
+{
+    return m_server->serverPort();
+}
+
+void WeatherServer::onNewConnection()
+{
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        ++m_openConnections;
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QObject::destroyed, this, [this]() { --m_openConnections; });
+
+        if (m_openConnections > MAX_CONNECTIONS) {
+            sendJson(socket, 503, errorBody("too many connections"));
+            continue;
+        }
+
+        // Зависший клиент не должен держать соединение бесконечно
+        QTimer::singleShot(CLIENT_TIMEOUT_MS, socket, [socket]() { socket->abort(); });
+
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { handleRequest(socket); });
+    }
+}
+
+void WeatherServer::handleRequest(QTcpSocket *socket)
+{
+    // Запрос уже разобран - остальное (тело, повторы) игнорируем
+    if (socket->property("handled").toBool()) {
+        socket->readAll();
+        return;
+    }
+
+    QByteArray buffer = socket->property("buffer").toByteArray() + socket->readAll();
+    int headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) {
+        if (buffer.size() > MAX_REQUEST_SIZE) {
+            socket->setProperty("handled", true);
+            sendJson(socket, 400, errorBody("request too large"));
+        } else {
+            socket->setProperty("buffer", buffer);
+        }
+        return;
+    }
+
+    socket->setProperty("handled", true);
+    socket->setProperty("buffer", QVariant());
+    ++m_requests;
+
+    QList<QByteArray> requestLine = buffer.left(buffer.indexOf("\r\n")).split(' ');
+    if (requestLine.size() < 2) {
+        sendJson(socket, 400, errorBody("malformed request"));
+        return;
+    }
+    if (requestLine[0] != "GET") {
+        sendJson(socket, 405, errorBody("only GET is supported"));
+        return;
+    }
+
+    QUrl url = QUrl::fromEncoded(requestLine[1]);
+    QString path = url.path();
+    QUrlQuery query(url);
+
+    if (path == "/locations") {
+        QJsonArray cities = QJsonArray::fromStringList(m_locations ? m_locations() : QStringList());
+        sendJson(socket, 200, QJsonDocument(cities).toJson(QJsonDocument::Compact));
+    } else if (path == "/weather") {
+        if (query.hasQueryItem("city")) {
+            QString city = query.queryItemValue("city", QUrl::FullyDecoded);
+            serveWeather(socket, QStringList() << city, true);
+        } else {
+            serveWeather(socket, m_locations ? m_locations() : QStringList(), false);
+        }
+    } else if (path == "/stats") {
+        const WeatherService::Stats service = m_service->stats();
+        QJsonObject stats;
+        stats["requests"] = m_requests;
+        stats["cacheHits"] = service.cacheHits;
+        stats["coalesced"] = service.coalesced;
+        stats["upstreamFetches"] = service.fetches;
+        stats["upstreamErrors"] = service.errors;
+        stats["openConnections"] = m_openConnections;
+        stats["cachedLocations"] = m_service->cachedLocations();
+        sendJson(socket, 200, QJsonDocument(stats).toJson(QJsonDocument::Compact));
+    } else {
+        sendJson(socket, 404, errorBody("unknown path"));
+    }
+}
+
+void WeatherServer::serveWeather(QTcpSocket *socket, const QStringList &cities, bool single)
+{
+    PendingPtr pending(new PendingResponse);
+    pending->socket = socket;
+    pending->cities = cities;
+    pending->remaining = 0;
+    pending->single = single;
+
+    QStringList known;
+    for (const QString &city : cities) {
+        GeoPoint point;
+        if (!m_resolver || !m_resolver(city, &point)) {
+            // Неизвестный город: в общем ответе просто будет отмечен как недоступный
+            continue;
+        }
+        m_service->setPosition(city, point);
+        known << city;
+    }
+
+    pending->remaining = known.size();
+    if (pending->remaining == 0) {
+        complete(pending);
+        return;
+    }
+
+    // Свежий кэш, слияние с запросом в пути и с подписками окна - на стороне сервиса
+    for (const QString &city : known) {
+        m_service->fetch(city, WeatherService::Brief, this, [this, pending, city](const WeatherResult &result) {
+            if (result.isValid()) {
+                pending->results.insert(city, result);
+            }
+            if (--pending->remaining == 0) {
+                complete(pending);
+            }
+        });
+    }
+}
+
+void WeatherServer::complete(const PendingPtr &pending)
+{
+    QTcpSocket *socket = pending->socket.data();
+    if (!socket) return;
+
+    if (pending->single) {
+        QString city = pending->cities.value(0);
+        auto found = pending->results.constFind(city);
+        if (found == pending->results.constEnd()) {
+            GeoPoint point;
+            bool known = m_resolver && m_resolver(city, &point);
+            sendJson(socket, known ? 502 : 404, errorBody(known ? "upstream unavailable" : "unknown city"));
+            return;
+        }
+
+        QJsonObject obj = buildLocationJson(found.value());
+        sendJson(socket, 200, QJsonDocument(obj).toJson(QJsonDocument::Compact));
+        return;
+    }
+
+    QJsonArray locations;
+    for (const QString &city : pending->cities) {
+        auto found = pending->results.constFind(city);
+        if (found == pending->results.constEnd()) {
+            QJsonObject missing;
+            missing["city"] = city;
+            missing["error"] = QStringLiteral("unavailable");
+            locations.append(missing);
+            continue;
+        }
+        locations.append(buildLocationJson(found.value()));
+    }
+    sendJson(socket, 200, QJsonDocument(locations).toJson(QJsonDocument::Compact));
+}
+
+void WeatherServer::sendJson(QTcpSocket *socket, int status, const QByteArray &body)
+{
+    QByteArray response;
+    response.reserve(body.size() + 160);
+    response += "HTTP/1.1 " + QByteArray::number(status) + ' ' + reasonPhrase(status) + "\r\n";
+    response += "Content-Type: application/json; charset=utf-8\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += "Access-Control-Allow-Origin: *\r\n";
+    response += "Connection: close\r\n\r\n";
+    response += body;
+
+    socket->write(response);
+    // Соединение закроется после отправки всех данных
+    socket->disconnectFromHost();
+}
+
+QJsonObject WeatherServer::buildLocationJson(const WeatherResult &result) const
+{
+    // Поля повторяют WeatherData/ForecastData главного окна
+    const WeatherData &current = result.current();
+    QJsonObject weather;
+    weather["temp"] = double(current.temp);
+    weather["feelsLike"] = double(current.feelsLike);
+    weather["humidity"] = int(current.humidity);
+    weather["windSpeed"] = double(current.windSpeed);
+    weather["weatherCode"] = int(current.weatherCode);
+    weather["dateTime"] = QDateTime::fromSecsSinceEpoch(current.time, Qt::UTC).toString(Qt::ISODate);
+
+    // Дни хранятся как местная полночь в UTC - наружу отдаём настоящий момент времени
+    QJsonArray forecast;
+    const QVector<ForecastData> &daily = result.daily();
+    for (int i = 0; i < qMin(daily.size(), FORECAST_DAYS); ++i) {
+        QJsonObject day;
+        day["dateTime"] = QDateTime::fromSecsSinceEpoch(daily[i].time - result.utcOffset(), Qt::UTC)
+                              .toString(Qt::ISODate);
+        day["tempMin"] = double(daily[i].tempMin);
+        day["tempMax"] = double(daily[i].tempMax);
+        day["weatherCode"] = int(daily[i].weatherCode);
+        forecast.append(day);
+    }
+
+    QJsonObject obj;
+    obj["city"] = result.location();
+    obj["current"] = weather;
+    obj["forecast"] = forecast;
+    obj["fetchedAt"] = QDateTime::fromMSecsSinceEpoch(result.fetchedAt(), Qt::UTC).toString(Qt::ISODate);
+    obj["stale"] = !m_service->isFresh(result);
+    return obj;
+}
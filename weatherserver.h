@@ -0,0 +1,72 @@
+#ifndef WEATHERSERVER_H
+#define WEATHERSERVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QSharedPointer>
+#include <QPointer>
+#include <functional>
+#include "cityindex.h"
+#include "weatherservice.h"
+
+class QTcpServer;
+class QTcpSocket;
+
+// Встроенный HTTP-сервер: отдаёт погоду текущего города и избранного в JSON.
+// Данные берутся из общего WeatherService: одновременные запросы одного города
+// и открытое окно с тем же городом дают один запрос к Open-Meteo.
+//
+//   GET /locations            - список городов
+//   GET /weather              - погода по всем городам
+//   GET /weather?city=<name>  - погода по одному городу
+//   GET /stats                - счётчики сервера
+class WeatherServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef std::function<QStringList()> LocationsProvider;
+    typedef std::function<bool(const QString &, GeoPoint *)> LocationResolver;
+
+    explicit WeatherServer(WeatherService *service, QObject *parent = nullptr);
+
+    void setLocationsProvider(const LocationsProvider &provider) { m_locations = provider; }
+    void setLocationResolver(const LocationResolver &resolver) { m_resolver = resolver; }
+
+    bool listen(quint16 port, const QHostAddress &address = QHostAddress::Any);
+    quint16 serverPort() const;
+
+private slots:
+    void onNewConnection();
+
+private:
+    // Ответ клиенту, ожидающий один или несколько городов
+    struct PendingResponse {
+        QPointer<QTcpSocket> socket;
+        QStringList cities;
+        QHash<QString, WeatherResult> results;
+        int remaining;
+        bool single;
+    };
+    typedef QSharedPointer<PendingResponse> PendingPtr;
+
+    void handleRequest(QTcpSocket *socket);
+    void serveWeather(QTcpSocket *socket, const QStringList &cities, bool single);
+    void complete(const PendingPtr &pending);
+    void sendJson(QTcpSocket *socket, int status, const QByteArray &body);
+
+    QJsonObject buildLocationJson(const WeatherResult &result) const;
+
+    QTcpServer *m_server;
+    WeatherService *m_service;
+    LocationsProvider m_locations;
+    LocationResolver m_resolver;
+
+    // Счётчики для /stats; кэш и слияние запросов считает сервис
+    qint64 m_requests;
+    int m_openConnections;
+};
+
+#endif // WEATHERSERVER_H
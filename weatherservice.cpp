@@ -0,0 +1,535 @@
+#include "weatherservice.h"
+#include "networkcapture.h"
+#include <QNetworkReply>
+#include <QUrlQuery>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QSettings>
+#include <QDateTime>
+#include <QTimer>
+#include <QtMath>
+#include <QDebug>
+
+namespace {
+const qint64 FRESH_MS = 5 * 60 * 1000;
+const qint64 EVICT_MS = 60 * 60 * 1000;
+const int REFRESH_INTERVAL_MS = 10 * 60 * 1000;
+
+RequestScheduler::Priority priorityFor(WeatherService::Detail detail)
+{
+    return detail == WeatherService::Full ? RequestScheduler::CurrentCity : RequestScheduler::Favorites;
+}
+}
+
+class WeatherResultData : public QSharedData
+{
+public:
+    WeatherResultData()
+        : valid(false)
+        , hasExtras(false)
+        , utcOffset(0)
+        , fetchedAt(0)
+    {
+        position.lat = 0;
+        position.lon = 0;
+        current.time = 0;
+        current.temp = 0;
+        current.feelsLike = 0;
+        current.windSpeed = 0;
+        current.locationId = LocationTable::InvalidId;
+        current.humidity = 0;
+        current.weatherCode = 0;
+    }
+
+    bool valid;
+    bool hasExtras;
+    QString location;
+    GeoPoint position;
+    qint64 utcOffset;
+    qint64 fetchedAt;
+    WeatherData current;
+    QVector<ForecastData> daily;
+    QVector<float> hourlyTemps;
+    QVector<quint8> hourlyCodes;
+    SnapshotExtras extras;
+};
+
+WeatherResult::WeatherResult()
+    : d(new WeatherResultData)
+{
+}
+
+WeatherResult::WeatherResult(WeatherResultData *data)
+    : d(data)
+{
+}
+
+WeatherResult::WeatherResult(const WeatherResult &other) = default;
+WeatherResult &WeatherResult::operator=(const WeatherResult &other) = default;
+WeatherResult::~WeatherResult() = default;
+
+bool WeatherResult::isValid() const { return d->valid; }
+bool WeatherResult::hasExtras() const { return d->hasExtras; }
+QString WeatherResult::location() const { return d->location; }
+GeoPoint WeatherResult::position() const { return d->position; }
+qint64 WeatherResult::utcOffset() const { return d->utcOffset; }
+qint64 WeatherResult::fetchedAt() const { return d->fetchedAt; }
+const WeatherData &WeatherResult::current() const { return d->current; }
+const QVector<ForecastData> &WeatherResult::daily() const { return d->daily; }
+const QVector<float> &WeatherResult::hourlyTemps() const { return d->hourlyTemps; }
+const QVector<quint8> &WeatherResult::hourlyCodes() const { return d->hourlyCodes; }
+const SnapshotExtras &WeatherResult::extras() const { return d->extras; }
+
+WeatherService::WeatherService(const QString &forecastUrl, const QString &geocodingUrl, QObject *parent)
+    : QObject(parent)
+    , m_forecastUrl(forecastUrl)
+    , m_geocodingUrl(geocodingUrl)
+    , m_language("ru")
+    , m_scheduler(nullptr)
+    , m_snapshots(nullptr)
+    , m_refreshTimer(new QTimer(this))
+    , m_nextSubscription(1)
+{
+    m_stats.fetches = 0;
+    m_stats.cacheHits = 0;
+    m_stats.coalesced = 0;
+    m_stats.errors = 0;
+
+    // Одно расписание на все города, за которыми кто-то следит
+    m_refreshTimer->setInterval(REFRESH_INTERVAL_MS);
+    connect(m_refreshTimer, &QTimer::timeout, this, &WeatherService::refreshAll);
+    m_refreshTimer->start();
+}
+
+RequestScheduler *WeatherService::scheduler()
+{
+    if (m_scheduler) return m_scheduler;
+
+    // С --capture/--replay это записывающий или воспроизводящий менеджер
+    QNetworkAccessManager *network = NetworkCapture::createManager(nullptr);
+
+    // Игнорируем SSL ошибки
+    connect(network, &QNetworkAccessManager::sslErrors, this, [](QNetworkReply *reply, const QList<QSslError> &) {
+        reply->ignoreSslErrors();
+    });
+
+    // Все запросы идут через планировщик: поиск не ждёт обновления избранного
+    m_scheduler = new RequestScheduler(network, this);
+    network->setParent(m_scheduler);
+
+    QSettings settings;
+    settings.beginGroup("hostLimits");
+    const QStringList hosts = settings.childKeys();
+    for (const QString &host : hosts) {
+        m_scheduler->setHostLimit(host, settings.value(host).toInt());
+    }
+    settings.endGroup();
+
+    qDebug() << "Network scheduler created, host limits:" << hosts;
+    return m_scheduler;
+}
+
+void WeatherService::setPosition(const QString &location, const GeoPoint &point)
+{
+    m_positions.insert(location, point);
+}
+
+bool WeatherService::position(const QString &location, GeoPoint *point) const
+{
+    auto it = m_positions.constFind(location);
+    if (it == m_positions.constEnd()) return false;
+    *point = it.value();
+    return true;
+}
+
+void WeatherService::resolve(const QString &location, RequestScheduler::Priority priority, QObject *context,
+                             const std::function<void(const GeoPoint &)> &onResolved)
+{
+    geocode(location, priority, context, [onResolved](bool ok, const GeoPoint &point) {
+        if (ok) onResolved(point);
+    });
+}
+
+void WeatherService::geocode(const QString &location, RequestScheduler::Priority priority, QObject *context,
+                             const std::function<void(bool ok, const GeoPoint &)> &onDone)
+{
+    GeoPoint point;
+    if (position(location, &point)) {
+        onDone(true, point);
+        return;
+    }
+
+    // Место, заданное координатами, хранится под ними же - геокодер не нужен
+    if (CityIndex::parseCoordinates(location, &point)) {
+        m_positions.insert(location, point);
+        onDone(true, point);
+        return;
+    }
+
+    qDebug() << "Resolving coordinates for:" << location;
+
+    QStringList parts = location.split(", ");
+    QUrl geoUrl(m_geocodingUrl);
+    QUrlQuery geoQuery;
+    geoQuery.addQueryItem("name", parts[0]);
+    geoQuery.addQueryItem("count", "1");
+    geoQuery.addQueryItem("language", m_language);
+    geoQuery.addQueryItem("format", "json");
+    geoUrl.setQuery(geoQuery);
+
+    QNetworkRequest request(geoUrl);
+    request.setHeader(QNetworkRequest::UserAgentHeader, "SimpleWeather/1.0");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    request.setTransferTimeout(10000);
+#endif
+
+    scheduler()->get(request, priority, location, context, [this, location, onDone](QNetworkReply *reply) {
+        GeoPoint point;
+        if (reply->error() != QNetworkReply::NoError) {
+            qDebug() << "Geo error:" << reply->errorString();
+            onDone(false, point);
+            return;
+        }
+
+        QJsonArray results = QJsonDocument::fromJson(reply->readAll()).object()["results"].toArray();
+        if (results.isEmpty()) {
+            qDebug() << "No geocoding results found:" << location;
+            onDone(false, point);
+            return;
+        }
+
+        QJsonObject found = results[0].toObject();
+        point.lat = found["latitude"].toDouble();
+        point.lon = found["longitude"].toDouble();
+        qDebug() << "Got coordinates:" << location << point.lat << point.lon;
+
+        m_positions.insert(location, point);
+        emit positionResolved(location, point);
+        onDone(true, point);
+    });
+}
+
+WeatherService::Subscription WeatherService::subscribe(const QString &location, Detail detail,
+                                                       QObject *context, const Callback &onUpdate)
+{
+    Watcher watcher;
+    watcher.id = m_nextSubscription++;
+    watcher.context = context;
+    watcher.callback = onUpdate;
+    watcher.detail = detail;
+    watcher.once = false;
+
+    Entry &entry = m_entries[location];
+    entry.watchers.append(watcher);
+    m_subscriptions.insert(watcher.id, location);
+
+    const WeatherResult &result = entry.result;
+    if (result.isValid()) {
+        deliverLater(watcher.id, location, context, onUpdate);
+    }
+
+    // Кэш показывается сразу; недостающие воздух и море догружаются
+    if (result.isValid() && isFresh(result) && (detail == Brief || result.hasExtras())) {
+        ++m_stats.cacheHits;
+    } else {
+        ensureFetched(location, detail);
+    }
+    return watcher.id;
+}
+
+void WeatherService::unsubscribe(Subscription subscription)
+{
+    QString location = m_subscriptions.take(subscription);
+    auto it = m_entries.find(location);
+    if (it == m_entries.end()) return;
+
+    QList<Watcher> &watchers = it.value().watchers;
+    for (int i = 0; i < watchers.size(); ++i) {
+        if (watchers[i].id == subscription) {
+            watchers.removeAt(i);
+            break;
+        }
+    }
+}
+
+void WeatherService::fetch(const QString &location, Detail detail, QObject *context, const Callback &onReady)
+{
+    Entry &entry = m_entries[location];
+    const WeatherResult &result = entry.result;
+
+    if (result.isValid() && isFresh(result) && (detail == Brief || result.hasExtras())) {
+        ++m_stats.cacheHits;
+        deliverLater(0, location, context, onReady);
+        return;
+    }
+
+    Watcher watcher;
+    watcher.id = 0;
+    watcher.context = context;
+    watcher.callback = onReady;
+    watcher.detail = detail;
+    watcher.once = true;
+    entry.watchers.append(watcher);
+
+    ensureFetched(location, detail);
+}
+
+void WeatherService::refresh(const QString &location)
+{
+    Detail detail = Brief;
+    const QList<Watcher> watchers = m_entries.value(location).watchers;
+    for (const Watcher &watcher : watchers) {
+        if (watcher.detail == Full) detail = Full;
+    }
+    ensureFetched(location, detail);
+}
+
+void WeatherService::refreshAll()
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QStringList locations;
+
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        Entry &entry = it.value();
+        if (entry.watchers.isEmpty() && entry.inFlight == 0) {
+            // Никто не следит: кэш держим, пока он может пригодиться
+            if (now - entry.result.fetchedAt() > EVICT_MS) {
+                it = m_entries.erase(it);
+                continue;
+            }
+        } else {
+            locations << it.key();
+        }
+        ++it;
+    }
+
+    for (const QString &location : locations) {
+        refresh(location);
+    }
+}
+
+void WeatherService::ensureFetched(const QString &location, Detail detail)
+{
+    Entry &entry = m_entries[location];
+
+    // Запрос этого города уже в пути и даст не меньше нужного - ждём его
+    if (entry.inFlight > 0 && (entry.fetching == Full || detail == Brief)) {
+        ++m_stats.coalesced;
+        return;
+    }
+
+    ++entry.inFlight;
+    entry.fetching = qMax(entry.fetching, detail);
+    ++m_stats.fetches;
+
+    geocode(location, priorityFor(detail), this, [this, location, detail](bool ok, const GeoPoint &point) {
+        if (!ok) {
+            endFetch(location);
+            fetchFailed(location);
+            return;
+        }
+        startSnapshot(location, point, detail);
+    });
+}
+
+void WeatherService::startSnapshot(const QString &location, const GeoPoint &point, Detail detail)
+{
+    if (!m_snapshots) {
+        m_snapshots = new SnapshotAggregator(scheduler(), m_forecastUrl, this);
+        connect(m_snapshots, &SnapshotAggregator::snapshotReady, this, &WeatherService::onSnapshotReady);
+    }
+    m_snapshots->request(location, point, priorityFor(detail), detail == Full);
+}
+
+void WeatherService::onSnapshotReady(const LocationSnapshot &snapshot)
+{
+    auto it = m_entries.find(snapshot.location);
+    if (it == m_entries.end()) return;
+
+    endFetch(snapshot.location);
+
+    Entry &entry = it.value();
+    const WeatherResult previous = entry.result;
+    bool extras = snapshot.withExtras;
+    SnapshotExtras values = snapshot.extras;
+    if (!extras && previous.hasExtras()) {
+        // Краткий запрос не трогает воздух и море - остаются прежние
+        values = previous.extras();
+        extras = true;
+    }
+
+    if (!snapshot.hasForecast) {
+        if (snapshot.withExtras && previous.isValid()) {
+            // Прогноз не успел - обновляем хотя бы качество воздуха и море
+            WeatherResultData *data = new WeatherResultData(*previous.d);
+            data->extras = snapshot.extras;
+            data->hasExtras = true;
+            publish(snapshot.location, WeatherResult(data));
+            return;
+        }
+        fetchFailed(snapshot.location);
+        return;
+    }
+
+    WeatherResult result = parse(snapshot.location, snapshot.position, snapshot.forecast, values, extras);
+    emit resultReady(result);
+    publish(snapshot.location, result);
+}
+
+void WeatherService::endFetch(const QString &location)
+{
+    auto it = m_entries.find(location);
+    if (it == m_entries.end()) return;
+
+    // Счётчик уменьшается только здесь: слитые запросы в пути не теряются
+    Entry &entry = it.value();
+    if (entry.inFlight > 0 && --entry.inFlight == 0) {
+        entry.fetching = Brief;
+    }
+}
+
+void WeatherService::fetchFailed(const QString &location)
+{
+    ++m_stats.errors;
+    auto it = m_entries.find(location);
+    if (it == m_entries.end()) return;
+
+    Entry &entry = it.value();
+    // Разовым ожидающим - прежний результат (или пустой), подписчики ждут следующего
+    const WeatherResult result = entry.result;
+    QList<Watcher> once;
+    for (int i = entry.watchers.size() - 1; i >= 0; --i) {
+        if (entry.watchers[i].once) {
+            once.prepend(entry.watchers.takeAt(i));
+        }
+    }
+    for (const Watcher &watcher : once) {
+        if (watcher.context) watcher.callback(result);
+    }
+}
+
+void WeatherService::ingest(const QString &location, const QJsonObject &forecast)
+{
+    if (forecast["current"].toObject().isEmpty()) return;
+
+    GeoPoint point;
+    point.lat = forecast["latitude"].toDouble();
+    point.lon = forecast["longitude"].toDouble();
+    position(location, &point);
+
+    WeatherResult result = parse(location, point, forecast, SnapshotExtras(), false);
+    emit resultReady(result);
+    publish(location, result);
+}
+
+void WeatherService::publish(const QString &location, const WeatherResult &result)
+{
+    Entry &entry = m_entries[location];
+    entry.result = result;
+
+    // Колбэк может подписаться или отписаться - работаем по снимку списка
+    const QList<Watcher> watchers = entry.watchers;
+    for (int i = entry.watchers.size() - 1; i >= 0; --i) {
+        if (entry.watchers[i].once || !entry.watchers[i].context) {
+            if (!entry.watchers[i].once) m_subscriptions.remove(entry.watchers[i].id);
+            entry.watchers.removeAt(i);
+        }
+    }
+
+    for (const Watcher &watcher : watchers) {
+        if (!watcher.context) continue;
+        if (!watcher.once && !m_subscriptions.contains(watcher.id)) continue;
+        watcher.callback(result);
+    }
+}
+
+void WeatherService::deliverLater(Subscription id, const QString &location, QObject *context, const Callback &callback)
+{
+    QTimer::singleShot(0, context, [this, id, location, callback]() {
+        // За время ожидания подписку могли снять
+        if (id && !m_subscriptions.contains(id)) return;
+        callback(m_entries.value(location).result);
+    });
+}
+
+WeatherResult WeatherService::cached(const QString &location) const
+{
+    return m_entries.value(location).result;
+}
+
+bool WeatherService::isFresh(const WeatherResult &result) const
+{
+    return result.isValid() && QDateTime::currentMSecsSinceEpoch() - result.fetchedAt() < FRESH_MS;
+}
+
+int WeatherService::cachedLocations() const
+{
+    int count = 0;
+    for (const Entry &entry : m_entries) {
+        if (entry.result.isValid()) ++count;
+    }
+    return count;
+}
+
+WeatherResult WeatherService::parse(const QString &location, const GeoPoint &point, const QJsonObject &forecast,
+                                    const SnapshotExtras &extras, bool hasExtras)
+{
+    WeatherResultData *data = new WeatherResultData;
+    data->valid = true;
+    data->hasExtras = hasExtras;
+    data->location = location;
+    data->position = point;
+    data->fetchedAt = QDateTime::currentMSecsSinceEpoch();
+    data->extras = extras;
+
+    // Даты храним как местное время места, записанное в UTC: с unixtime
+    // добавляем смещение пояса, ISO-даты разбираем сразу как UTC
+    data->utcOffset = qint64(forecast["utc_offset_seconds"].toDouble());
+
+    const QJsonObject current = forecast["current"].toObject();
+    WeatherData &weather = data->current;
+    weather.locationId = m_locations.intern(location);
+    weather.time = qint64(current["time"].toDouble());
+    weather.temp = float(current["temperature_2m"].toDouble());
+    weather.feelsLike = float(current["apparent_temperature"].toDouble());
+    weather.humidity = quint8(qBound(0, current["relative_humidity_2m"].toInt(), 100));
+    weather.windSpeed = float(current["wind_speed_10m"].toDouble());
+    weather.weatherCode = quint8(current["weather_code"].toInt());
+
+    const QJsonObject daily = forecast["daily"].toObject();
+    const QJsonArray times = daily["time"].toArray();
+    const QJsonArray tempMax = daily["temperature_2m_max"].toArray();
+    const QJsonArray tempMin = daily["temperature_2m_min"].toArray();
+    const QJsonArray codes = daily["weather_code"].toArray();
+
+    data->daily.reserve(times.size());
+    for (int i = 0; i < times.size(); ++i) {
+        ForecastData fd;
+        if (times[i].isDouble()) {
+            fd.time = qint64(times[i].toDouble()) + data->utcOffset;
+        } else {
+            QDate date = QDate::fromString(times[i].toString(), Qt::ISODate);
+            fd.time = QDateTime(date, QTime(0, 0), Qt::UTC).toSecsSinceEpoch();
+        }
+        fd.tempMax = float(tempMax[i].toDouble());
+        fd.tempMin = float(tempMin[i].toDouble());
+        fd.weatherCode = quint8(codes[i].toInt());
+        data->daily.append(fd);
+    }
+
+    const QJsonObject hourly = forecast["hourly"].toObject();
+    const QJsonArray hourlyTemps = hourly["temperature_2m"].toArray();
+    const QJsonArray hourlyCodes = hourly["weather_code"].toArray();
+    data->hourlyTemps.reserve(hourlyTemps.size());
+    for (const QJsonValue &value : hourlyTemps) {
+        data->hourlyTemps.append(float(value.toDouble()));
+    }
+    data->hourlyCodes.reserve(hourlyCodes.size());
+    for (const QJsonValue &value : hourlyCodes) {
+        data->hourlyCodes.append(quint8(value.toInt()));
+    }
+
+    qDebug() << "Weather result:" << location << weather.temp << weather.weatherCode
+             << "days:" << data->daily.size() << "extras:" << hasExtras;
+    return WeatherResult(data);
+}
@@ -0,0 +1,155 @@
+#ifndef WEATHERSERVICE_H
+#define WEATHERSERVICE_H
+
+#include <QObject>
+#include <QHash>
+#include <QPointer>
+#include <QSharedDataPointer>
+#include <QJsonObject>
+#include <functional>
+#include "cityindex.h"
+#include "weatherrecords.h"
+#include "requestscheduler.h"
+#include "snapshotaggregator.h"
+
+class QTimer;
+class QNetworkReply;
+class WeatherResultData;
+
+// Готовый результат по месту: неизменяемый и неявно разделяемый.
+// Все подписчики одного города получают одну и ту же копию данных.
+class WeatherResult
+{
+public:
+    WeatherResult();
+    WeatherResult(const WeatherResult &other);
+    WeatherResult &operator=(const WeatherResult &other);
+    ~WeatherResult();
+
+    bool isValid() const;
+    bool hasExtras() const;
+
+    QString location() const;
+    GeoPoint position() const;
+    qint64 utcOffset() const;
+    qint64 fetchedAt() const; // мс эпохи
+
+    const WeatherData &current() const;
+    const QVector<ForecastData> &daily() const;
+    // Ближайшие 24 часа: температура и код погоды по часам
+    const QVector<float> &hourlyTemps() const;
+    const QVector<quint8> &hourlyCodes() const;
+    const SnapshotExtras &extras() const;
+
+private:
+    friend class WeatherService;
+    explicit WeatherResult(WeatherResultData *data);
+
+    QSharedDataPointer<WeatherResultData> d;
+};
+
+// Общая часть окна, трея и сервера: одна сеть, один набор кэшей и одно
+// расписание обновления. Сколько бы представлений ни следили за городом,
+// запрос к Open-Meteo по нему один, результат разделяется между всеми.
+class WeatherService : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Detail {
+        Brief, // текущая погода, сутки по часам и прогноз по дням - один запрос
+        Full   // то же плюс качество воздуха и море
+    };
+
+    struct Stats {
+        qint64 fetches;
+        qint64 cacheHits;
+        qint64 coalesced;
+        qint64 errors;
+    };
+
+    typedef quint64 Subscription;
+    typedef std::function<void(const WeatherResult &)> Callback;
+
+    WeatherService(const QString &forecastUrl, const QString &geocodingUrl, QObject *parent = nullptr);
+
+    // Сеть создаётся при первом обращении; специализированные загрузчики идут через неё же
+    RequestScheduler *scheduler();
+    LocationTable &locations() { return m_locations; }
+
+    void setLanguage(const QString &code) { m_language = code; }
+    void setPosition(const QString &location, const GeoPoint &point);
+    bool position(const QString &location, GeoPoint *point) const;
+    void resolve(const QString &location, RequestScheduler::Priority priority, QObject *context,
+                 const std::function<void(const GeoPoint &)> &onResolved);
+
+    // Колбэк вызывается асинхронно: сразу с кэшем, если он есть, и на каждый новый результат.
+    // Не вызывается после unsubscribe или удаления context.
+    Subscription subscribe(const QString &location, Detail detail, QObject *context, const Callback &onUpdate);
+    void unsubscribe(Subscription subscription);
+    // Однократно: свежий кэш или результат ближайшей загрузки; при ошибке - прежний или пустой
+    void fetch(const QString &location, Detail detail, QObject *context, const Callback &onReady);
+    void refresh(const QString &location);
+
+    // Ответ, загруженный в обход сервиса (упреждающая загрузка подсказок)
+    void ingest(const QString &location, const QJsonObject &forecast);
+
+    WeatherResult cached(const QString &location) const;
+    bool isFresh(const WeatherResult &result) const;
+    Stats stats() const { return m_stats; }
+    int cachedLocations() const;
+
+signals:
+    // Один раз на каждый новый результат - для истории и оповещений
+    void resultReady(const WeatherResult &result);
+    void positionResolved(const QString &location, const GeoPoint &point);
+
+private:
+    struct Watcher {
+        Subscription id;
+        QPointer<QObject> context;
+        Callback callback;
+        Detail detail;
+        bool once;
+    };
+
+    struct Entry {
+        WeatherResult result;
+        QList<Watcher> watchers;
+        int inFlight;
+        Detail fetching;
+
+        Entry() : inFlight(0), fetching(Brief) {}
+    };
+
+    void ensureFetched(const QString &location, Detail detail);
+    void startSnapshot(const QString &location, const GeoPoint &point, Detail detail);
+    void geocode(const QString &location, RequestScheduler::Priority priority, QObject *context,
+                 const std::function<void(bool ok, const GeoPoint &)> &onDone);
+    void onSnapshotReady(const LocationSnapshot &snapshot);
+    // Завершение загрузки (успешной или нет) и отдельно - ответ ожидающим при ошибке
+    void endFetch(const QString &location);
+    void fetchFailed(const QString &location);
+    void publish(const QString &location, const WeatherResult &result);
+    void deliverLater(Subscription id, const QString &location, QObject *context, const Callback &callback);
+    void refreshAll();
+
+    WeatherResult parse(const QString &location, const GeoPoint &point, const QJsonObject &forecast,
+                        const SnapshotExtras &extras, bool hasExtras);
+
+    QString m_forecastUrl;
+    QString m_geocodingUrl;
+    QString m_language;
+    RequestScheduler *m_scheduler;
+    SnapshotAggregator *m_snapshots;
+    QTimer *m_refreshTimer;
+
+    LocationTable m_locations;
+    QHash<QString, GeoPoint> m_positions;
+    QHash<QString, Entry> m_entries;
+    QHash<Subscription, QString> m_subscriptions;
+    Subscription m_nextSubscription;
+    Stats m_stats;
+};
+
+#endif // WEATHERSERVICE_H